@@ -0,0 +1,31 @@
+#!/bin/sh
+# Events per second of pure_voter and gut_model_A with each lattice storage
+# layout, across grid sizes. Runs one replica to the given time; pure_voter
+# makes N^2 events per unit time and gut_model_A 3N^2/4.
+#
+# usage: bench_layout.sh <directory of the model binaries> [time] [grid sizes ...]
+
+dir=${1:?usage: bench_layout.sh <binary directory> [time] [grid sizes ...]}
+shift
+t=${1:-4}
+[ $# -gt 0 ] && shift
+sizes=${*:-64 256 1024 4096}
+picture=${TMPDIR:-/tmp}/bench_layout.ppm
+
+printf "%-12s %6s %-8s %12s\n" model N layout events/s
+for model in pure_voter gut_model_A; do
+	case $model in
+		pure_voter) per_site=1 ;;
+		gut_model_A) per_site=0.75 ;;
+	esac
+	for N in $sizes; do
+		for layout in row morton hilbert; do
+			start=$(date +%s.%N)
+			"$dir/$model" "$N" "$t" 1 "$picture" --seed=1 --distribution --layout=$layout > /dev/null
+			end=$(date +%s.%N)
+			awk -v m=$model -v N=$N -v l=$layout -v t=$t -v p=$per_site -v s=$start -v e=$end \
+				'BEGIN {printf "%-12s %6d %-8s %12.4g\n", m, N, l, p*N*N*t/(e-s)}'
+		done
+	done
+done
+rm -f "$picture"
@@ -0,0 +1,31 @@
+#!/bin/sh
+# Wall time of one replica of a model to the given time, across grid sizes,
+# as JSON. sites_per_second is N^2 * time / seconds: lattice sites advanced
+# one unit of model time per second of wall time.
+#
+# usage: bench_model.sh <model binary> [time] [grid sizes ...]
+
+binary=$1
+shift
+t=${1:-4}
+[ $# -gt 0 ] && shift
+sizes=${*:-64 256 1024}
+model=$(basename "$binary")
+picture=${TMPDIR:-/tmp}/bench_model_$$.ppm
+
+printf '{\n  "model": "%s",\n  "benchmarks": [' "$model"
+separator=
+for N in $sizes; do
+	case $model in
+		mc_2d_voter|mc_2d_AB_stratify) set -- "$N" "$t" 1 ;;
+		*) set -- "$N" "$t" 1 "$picture" ;;
+	esac
+	start=$(date +%s.%N)
+	"$binary" "$@" --seed=1 --distribution > /dev/null || exit 1
+	end=$(date +%s.%N)
+	awk -v sep="$separator" -v N=$N -v t=$t -v s=$start -v e=$end \
+		'BEGIN {printf "%s\n    {\"N\": %d, \"time\": %g, \"seconds\": %.4f, \"sites_per_second\": %.4g}", sep, N, t, e-s, N*N*t/(e-s)}'
+	separator=,
+done
+printf '\n  ]\n}\n'
+rm -f "$picture"
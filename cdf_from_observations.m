@@ -1,9 +1,17 @@
 function [mu, p, average] = cdf_from_observations(file)
 
-ms = load(file);
-total = numel(ms);
-average = sum(ms) / total;
-counts = histc(ms, 0:max(ms));
+% either one clone size per line, or "size count" lines from --distribution
+% this loads the whole file; for big runs, clone_stats <file> writes the
+% same mu p pairs in one pass
+data = load(file);
+if size(data, 2) == 2
+    ms = data(:,1); weights = data(:,2);
+else
+    ms = data; weights = ones(size(ms));
+end
+total = sum(weights);
+average = sum(ms .* weights) / total;
+counts = accumarray(ms + 1, weights, [max(ms)+1 1]);
 p = cumsum(counts) / total;
 mu = (0:max(ms)) / average;
 
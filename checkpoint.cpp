@@ -0,0 +1,106 @@
+#include "checkpoint.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+extern "C" {
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+}
+
+using namespace std;
+
+static const uint32_t checkpoint_version = 1;
+static const uint64_t page = 4096;
+
+checkpoint_header make_checkpoint_header(const char * model, const char * layout, uint32_t N)
+{
+	checkpoint_header h;
+	memset(&h, 0, sizeof(h));
+	strncpy(h.magic, "coarsen", sizeof(h.magic));
+	strncpy(h.model, model, sizeof(h.model) - 1);
+	strncpy(h.layout, layout, sizeof(h.layout) - 1);
+	h.version = checkpoint_version;
+	h.N = N;
+	return h;
+}
+
+static bool write_all(int fd, const void * data, size_t n)
+{
+	const char * p = static_cast<const char *>(data);
+	while(n > 0) {
+		ssize_t w = write(fd, p, n);
+		if(w < 0 && errno == EINTR) continue;
+		if(w < 0) return false;
+		p += w;
+		n -= w;
+	}
+	return true;
+}
+
+// makes a rename in the directory holding filename durable
+static bool sync_directory(const string & filename)
+{
+	const size_t slash = filename.rfind('/');
+	const string dir = slash == string::npos ? "." : slash == 0 ? "/" : filename.substr(0, slash);
+	int fd = open(dir.c_str(), O_RDONLY);
+	if(fd < 0) return false;
+	const bool ok = fsync(fd) == 0;
+	return close(fd) == 0 && ok;
+}
+
+bool save_checkpoint(const string & filename, checkpoint_header h,
+		const void * rng, size_t rng_bytes, const uint32_t * cells, size_t ncells)
+{
+	h.cells = ncells;
+	h.rng_bytes = rng_bytes;
+	h.cells_offset = (sizeof(h) + rng_bytes + page - 1) / page * page;
+
+	const string tmp = filename + ".tmp";
+	int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if(fd < 0) return false;
+	static const char zeros[page] = {0};
+	bool ok = write_all(fd, &h, sizeof(h))
+		&& write_all(fd, rng, rng_bytes)
+		&& write_all(fd, zeros, h.cells_offset - sizeof(h) - rng_bytes)
+		&& write_all(fd, cells, ncells * sizeof(uint32_t))
+		&& fsync(fd) == 0;
+	ok = close(fd) == 0 && ok;
+	if(ok) ok = rename(tmp.c_str(), filename.c_str()) == 0;
+	if(!ok) {
+		unlink(tmp.c_str());
+		return false;
+	}
+	return sync_directory(filename);
+}
+
+checkpoint::checkpoint(const string & filename): header_(0)
+{
+	int fd = open(filename.c_str(), O_RDONLY);
+	if(fd < 0) return;
+	struct stat st;
+	if(fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(checkpoint_header)) {
+		close(fd);
+		return;
+	}
+	size_t length = st.st_size;
+	void * p = mmap(0, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(p == MAP_FAILED) return;
+	mapping_ = shared_ptr<void>(p, [length](void * q) {munmap(q, length);});
+
+	const checkpoint_header * h = static_cast<const checkpoint_header *>(p);
+	if(strncmp(h->magic, "coarsen", sizeof(h->magic)) != 0
+			|| h->version != checkpoint_version
+			|| h->cells_offset + h->cells * sizeof(uint32_t) > length)
+		return;
+	header_ = h;
+}
+
+uint32_t * checkpoint::cells() const
+{
+	char * base = static_cast<char *>(mapping_.get());
+	return reinterpret_cast<uint32_t *>(base + header_->cells_offset);
+}
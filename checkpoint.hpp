@@ -0,0 +1,57 @@
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Checkpoint file: this header, the generator state, then (from the next
+// page boundary, so that it can be mapped in place) the raw lattice cells in
+// storage order.
+struct checkpoint_header {
+	char magic[8];   // "coarsen"
+	char model[16];
+	char layout[16];
+	uint32_t version;
+	uint32_t N;
+	uint64_t cells;  // number of uint32_t cells, including layout padding
+	uint64_t rng_bytes;
+	uint64_t cells_offset;
+	double time;
+	uint32_t nB;
+	uint32_t seed;
+};
+
+// Fills in the fixed fields of a header.
+checkpoint_header make_checkpoint_header(const char * model, const char * layout, uint32_t N);
+
+// Writes a checkpoint atomically: everything goes to filename.tmp, which is
+// flushed to disk and then renamed over filename, so a crash leaves either
+// the old checkpoint or the new one. Returns false on any error.
+bool save_checkpoint(const std::string & filename, checkpoint_header h,
+		const void * rng, size_t rng_bytes, const uint32_t * cells, size_t ncells);
+
+// A checkpoint mapped copy-on-write. cells() points into the mapping, so a
+// lattice can use it directly: pages are only read in when touched, and
+// only copied when written. The mapping lives as long as any copy of
+// mapping() does, and later checkpoints renamed over the file do not
+// disturb it.
+class checkpoint {
+public:
+	explicit checkpoint(const std::string & filename);
+
+	// false if the file could not be read or is not a checkpoint
+	bool ok() const {return header_ != 0;}
+
+	const checkpoint_header & header() const {return *header_;}
+	const void * rng() const {return header_ + 1;}
+	uint32_t * cells() const;
+	std::shared_ptr<void> mapping() const {return mapping_;}
+
+private:
+	std::shared_ptr<void> mapping_;
+	const checkpoint_header * header_;
+};
+
+#endif // CHECKPOINT_HPP
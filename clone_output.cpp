@@ -0,0 +1,121 @@
+#include "clone_output.hpp"
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+static const uint32_t clone_file_version = 1;
+
+bool parse_clone_format(const string & name, clone_format & format)
+{
+	if(name == "text")
+		format = clones_text;
+	else if(name == "binary")
+		format = clones_binary;
+	else
+		return false;
+	return true;
+}
+
+static void put_varint(string & s, uint64_t x)
+{
+	while(x >= 0x80) {
+		s.push_back(char(x | 0x80));
+		x >>= 7;
+	}
+	s.push_back(char(x));
+}
+
+void clone_writer::header(ostream & os, double time) const
+{
+	if(format != clones_binary) return;
+	clone_file_header h;
+	memset(&h, 0, sizeof(h));
+	strncpy(h.magic, "clones", sizeof(h.magic));
+	strncpy(h.model, model, sizeof(h.model) - 1);
+	h.version = clone_file_version;
+	h.N = N;
+	h.time = time;
+	h.seed = seed;
+	h.runs = runs;
+	os.write(reinterpret_cast<const char *>(&h), sizeof(h));
+}
+
+void clone_writer::write(ostream & os, uint32_t replica, const clone_histogram & h) const
+{
+	if(format == clones_text) {
+		h.for_each([&](uint32_t, uint32_t size) {
+			os << size << "\n";
+		});
+	} else {
+		size_distribution d;
+		d.add(h);
+		write(os, replica, d);
+	}
+}
+
+void clone_writer::write(ostream & os, uint32_t replica, const size_distribution & d) const
+{
+	if(format == clones_text) {
+		os << d;
+		return;
+	}
+	string block;
+	uint32_t pairs = 0;
+	uint32_t previous = 0;
+	d.for_each([&](uint32_t size, uint64_t count) {
+		put_varint(block, size - previous);
+		put_varint(block, count);
+		previous = size;
+		pairs++;
+	});
+	string start;
+	put_varint(start, replica);
+	put_varint(start, pairs);
+	os << start << block;
+}
+
+static bool get_varint(FILE * f, uint64_t & x, bool & end)
+{
+	x = 0;
+	end = false;
+	for(int shift = 0; shift < 64; shift += 7) {
+		int c = getc_unlocked(f);
+		if(c == EOF) {
+			end = shift == 0;
+			return false;
+		}
+		x |= uint64_t(c & 0x7f) << shift;
+		if(!(c & 0x80)) return true;
+	}
+	return false;
+}
+
+bool read_clone_file(FILE * f, clone_file_header & h, size_distribution & d)
+{
+	if(fread(reinterpret_cast<char *>(&h) + sizeof(h.magic), sizeof(h) - sizeof(h.magic), 1, f) != 1
+			|| strncmp(h.magic, "clones", sizeof(h.magic)) != 0
+			|| h.version != clone_file_version)
+		return false;
+
+	uint64_t replica, pairs, size, step, count;
+	bool end;
+	while(get_varint(f, replica, end)) {
+		if(!get_varint(f, pairs, end)) return false;
+		size = 0;
+		for(uint64_t p = 0; p < pairs; ++p) {
+			if(!get_varint(f, step, end) || !get_varint(f, count, end)) return false;
+			size += step;
+			d.add(size, count);
+		}
+	}
+	return end && !ferror(f);
+}
+
+void buffer_standard_output()
+{
+	static vector<char> buffer(1 << 20);
+	ios::sync_with_stdio(false);
+	cout.rdbuf()->pubsetbuf(&buffer[0], buffer.size());
+}
@@ -0,0 +1,72 @@
+#ifndef CLONE_OUTPUT_HPP
+#define CLONE_OUTPUT_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include "clone_sizes.hpp"
+
+enum clone_format {
+	clones_text,   // one size per line, or "size count" lines for a distribution
+	clones_binary  // a header, then blocks of varint (size, count) pairs
+};
+
+// "text" and "binary"; returns false for any other name
+bool parse_clone_format(const std::string & name, clone_format & format);
+
+// Binary clone size files start with this header, written as it is laid out
+// in memory. Then come blocks, one for each replica, in replica order, or a
+// single one for a distribution summed over all replicas:
+//   varint replica (all_replicas for a summed distribution)
+//   varint number of pairs
+//   that many pairs of varint size increment (over the previous size of the
+//   block, starting from 0) and varint count
+// where a varint is an unsigned LEB128 number: 7 bits a byte, low bits first,
+// with the top bit set on every byte but the last.
+struct clone_file_header {
+	char magic[8];  // "clones"
+	char model[16];
+	uint32_t version;
+	uint32_t N;
+	double time;
+	uint32_t seed;
+	uint32_t runs;
+};
+
+static const uint32_t all_replicas = 0xffffffff;
+
+// Writes the clone sizes of one run to a stream in either format. For text
+// the header is left out and the output is what the models have always
+// written.
+class clone_writer {
+public:
+	clone_writer(clone_format format_, const char * model_, uint32_t N_, uint32_t seed_, uint32_t runs_):
+		format(format_), model(model_), N(N_), seed(seed_), runs(runs_) {}
+
+	clone_format output_format() const {return format;}
+
+	// the header of a binary file of clone sizes at the given time
+	void header(std::ostream & os, double time) const;
+
+	// the sizes of every clone of one replica
+	void write(std::ostream & os, uint32_t replica, const clone_histogram & h) const;
+	// the sizes of clones, counted, for one replica or all_replicas
+	void write(std::ostream & os, uint32_t replica, const size_distribution & d) const;
+
+private:
+	const clone_format format;
+	const char * model;
+	const uint32_t N, seed, runs;
+};
+
+// Reads a binary clone size file from f, where the magic has already been
+// read (and matched) into h, adding the sizes of every block to d. Returns
+// false if the file is cut short or is not a clone size file.
+bool read_clone_file(FILE * f, clone_file_header & h, size_distribution & d);
+
+// Gives standard output a large buffer, so the models' output goes out in
+// big writes. Call before anything is written to it.
+void buffer_standard_output();
+
+#endif // CLONE_OUTPUT_HPP
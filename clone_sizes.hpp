@@ -0,0 +1,101 @@
+#ifndef CLONE_SIZES_HPP
+#define CLONE_SIZES_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// Number of cells carrying each label. Labels are dense (hilbert indices or
+// relabelling counters, all below the number of sites), so a flat table
+// indexed by label replaces a map: one increment per cell, no allocation
+// once the table has grown to size.
+//
+// The lattices keep one up to date as cells are overwritten, with remove and
+// move, so the number of surviving clones and their mean size can be read at
+// any time without looking at the lattice.
+class clone_histogram {
+public:
+	clone_histogram(): live(0), total(0) {}
+
+	void clear() {
+		counts.assign(counts.size(), 0);
+		live = 0;
+		total = 0;
+	}
+
+	void add(uint32_t label) {
+		if(label >= counts.size())
+			counts.resize(label + 1, 0);
+		if(counts[label]++ == 0) live++;
+		total++;
+	}
+
+	// precondition: label is present
+	void remove(uint32_t label) {
+		if(--counts[label] == 0) live--;
+		total--;
+	}
+
+	// a cell going over from one label to another that is already present,
+	// as when it copies a neighbour
+	void move(uint32_t from, uint32_t to) {
+		if(--counts[from] == 0) live--;
+		if(counts[to]++ == 0) live++;
+	}
+
+	uint32_t clones() const {return live;}
+	uint64_t cells() const {return total;}
+	double mean() const {return live ? double(total) / live : 0.0;}
+
+	// f(label, size) for every label present, in increasing label order
+	template<typename F>
+	void for_each(F f) const {
+		for(uint32_t l = 0; l < counts.size(); ++l)
+			if(counts[l]) f(l, counts[l]);
+	}
+
+private:
+	std::vector<uint32_t> counts;
+	uint32_t live;
+	uint64_t total;
+};
+
+// Number of clones of each size, summed over any number of lattices. This is
+// what the octave scripts rebuild from the list of clone sizes, so writing it
+// instead of that list loses nothing.
+class size_distribution {
+public:
+	void add(uint32_t size, uint64_t clones = 1) {
+		if(size >= counts.size())
+			counts.resize(size + 1, 0);
+		counts[size] += clones;
+	}
+
+	void add(const clone_histogram & h) {
+		h.for_each([this](uint32_t, uint32_t size) {add(size);});
+	}
+
+	void merge(const size_distribution & d) {
+		for(uint32_t s = 0; s < d.counts.size(); ++s)
+			if(d.counts[s]) add(s, d.counts[s]);
+	}
+
+	// f(size, clones) for every size that occurred, in increasing order
+	template<typename F>
+	void for_each(F f) const {
+		for(uint32_t s = 0; s < counts.size(); ++s)
+			if(counts[s]) f(s, counts[s]);
+	}
+
+	// one "size count" line for every size that occurred
+	friend std::ostream & operator<<(std::ostream & os, const size_distribution & d) {
+		for(uint32_t s = 0; s < d.counts.size(); ++s)
+			if(d.counts[s]) os << s << " " << d.counts[s] << "\n";
+		return os;
+	}
+
+private:
+	std::vector<uint64_t> counts;
+};
+
+#endif // CLONE_SIZES_HPP
@@ -0,0 +1,231 @@
+/* clone size statistics from the output of the models */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "cmdline.hpp"
+#include "clone_sizes.hpp"
+#include "clone_output.hpp"
+
+// Parses clone sizes as the models write them as text, either one size per
+// line or "size count" lines from --distribution, from text handed over in
+// pieces of any length.
+class size_parser {
+public:
+	size_parser(size_distribution & d_): d(d_), fields(0), digits(0), value(0), bad(false) {}
+
+	void feed(const char * text, size_t n) {
+		for(size_t k = 0; k < n; ++k) {
+			char c = text[k];
+			if(c >= '0' && c <= '9') {
+				value = value*10 + (c - '0');
+				digits++;
+			} else if(c == ' ' || c == '\t' || c == '\r') {
+				end_field();
+			} else if(c == '\n') {
+				end_field();
+				end_line();
+			} else
+				bad = true;
+		}
+	}
+
+	// false if any line was neither a size nor a size and a count
+	bool finish() {
+		end_field();
+		end_line();
+		return !bad;
+	}
+
+private:
+	size_distribution & d;
+	uint64_t field[2];
+	int fields, digits;
+	uint64_t value;
+	bool bad;
+
+	void end_field() {
+		if(!digits) return;
+		if(fields < 2) field[fields] = value;
+		fields++;
+		digits = 0;
+		value = 0;
+	}
+	void end_line() {
+		if(fields == 1) d.add(field[0]);
+		else if(fields == 2) d.add(field[0], field[1]);
+		else if(fields > 2) bad = true;
+		fields = 0;
+	}
+};
+
+// Adds the clone sizes in a file, text or binary, to d, reading it a buffer
+// at a time, so memory goes with the largest clone rather than with the
+// length of the file. "-" is standard input.
+bool read_sizes(const std::string & filename, size_distribution & d)
+{
+	FILE * f = filename == "-" ? stdin : fopen(filename.c_str(), "rb");
+	if(!f) return false;
+	bool ok;
+	clone_file_header h;
+	size_t n = fread(h.magic, 1, sizeof(h.magic), f);
+	if(n == sizeof(h.magic) && memcmp(h.magic, "clones\0\0", sizeof(h.magic)) == 0)
+		ok = read_clone_file(f, h, d);
+	else {
+		size_parser parser(d);
+		parser.feed(h.magic, n);
+		std::vector<char> buffer(1 << 20);
+		while((n = fread(&buffer[0], 1, buffer.size(), f)) > 0)
+			parser.feed(&buffer[0], n);
+		ok = !ferror(f) && parser.finish();
+	}
+	if(f != stdin) fclose(f);
+	return ok;
+}
+
+struct size_summary {
+	uint64_t clones;  // including any of size 0
+	double cells;
+	double average() const {return clones ? cells / clones : 0.0;}
+};
+
+size_summary summarise(const size_distribution & d)
+{
+	size_summary s = {0, 0.0};
+	d.for_each([&](uint32_t size, uint64_t count) {
+		s.clones += count;
+		s.cells += double(size) * count;
+	});
+	return s;
+}
+
+// "mu p" lines as cdf_from_observations.m computes them: the fraction of
+// clones of at most each size 0 .. largest, against size / average
+void write_cdf(std::ostream & os, const size_distribution & d)
+{
+	const size_summary s = summarise(d);
+	uint64_t below = 0;
+	uint32_t next = 0;
+	d.for_each([&](uint32_t size, uint64_t count) {
+		for(; next < size; ++next)
+			os << next / s.average() << " " << double(below) / s.clones << "\n";
+		below += count;
+		os << size / s.average() << " " << double(below) / s.clones << "\n";
+		next = size + 1;
+	});
+}
+
+// "mu p" lines as pdf_from_observations.m computes them: the fraction of
+// clones of each size 1 .. largest times the average, against size / average
+void write_pdf(std::ostream & os, const size_distribution & d)
+{
+	const size_summary s = summarise(d);
+	uint32_t next = 1;
+	d.for_each([&](uint32_t size, uint64_t count) {
+		if(size == 0) return;
+		for(; next < size; ++next)
+			os << next / s.average() << " 0\n";
+		os << size / s.average() << " " << double(count) / s.clones * s.average() << "\n";
+		next = size + 1;
+	});
+}
+
+// The table pure_voter_scaling.m plots: for mu on a grid over [0, mu_max],
+// the fraction of clones larger than mu times the average, one column per
+// file, next to the scaling limit exp(-mu).
+void write_collapse(std::ostream & os, const std::vector<std::string> & files,
+		const std::vector<size_distribution> & d, double mu_max, int points)
+{
+	std::vector<size_summary> s(d.size());
+	os << "# mu limit";
+	for(size_t f = 0; f < files.size(); ++f)
+		os << " " << files[f];
+	os << "\n# average -";
+	for(size_t f = 0; f < d.size(); ++f) {
+		s[f] = summarise(d[f]);
+		os << " " << s[f].average();
+	}
+	os << "\n";
+
+	// the fraction of clones of at most each size, at the sizes that occur
+	std::vector<std::vector<std::pair<uint32_t, double> > > cdf(d.size());
+	for(size_t f = 0; f < d.size(); ++f) {
+		uint64_t below = 0;
+		d[f].for_each([&](uint32_t size, uint64_t count) {
+			below += count;
+			cdf[f].push_back(std::make_pair(size, double(below) / s[f].clones));
+		});
+	}
+
+	std::vector<size_t> at(d.size(), 0);
+	for(int k = 0; k <= points; ++k) {
+		double mu = mu_max * k / points;
+		os << mu << " " << exp(-mu);
+		for(size_t f = 0; f < d.size(); ++f) {
+			double m = floor(mu * s[f].average());
+			while(at[f] < cdf[f].size() && cdf[f][at[f]].first <= m)
+				at[f]++;
+			os << " " << 1.0 - (at[f] ? cdf[f][at[f] - 1].second : 0.0);
+		}
+		os << "\n";
+	}
+}
+
+int main(int argc, char ** argv)
+{
+	using namespace std;
+
+	cmdline args(argc, argv);
+	const bool collapse = args.has("collapse"), pdf = args.has("pdf"),
+		average = args.has("average");
+	if(args.size() <= 1 || collapse + pdf + average > 1) {
+		cout << "usage: " << args[0] << " [--pdf | --average |"
+			" --collapse [--mu-max=m] [--points=n]] <clone sizes> ..." << endl
+			<< "Reads clone sizes as the models write them, one per line, as"
+			" \"size count\" lines or binary (- for standard input), and writes the"
+			" rescaled cdf of all files together, their pdf, the number of"
+			" clones and average size of each, or a table of the scaling"
+			" collapse of each." << endl;
+		return -1;
+	}
+
+	vector<string> files;
+	for(size_t f = 1; f < args.size(); ++f)
+		files.push_back(args[f]);
+
+	vector<size_distribution> d(collapse || average ? files.size() : 1);
+	for(size_t f = 0; f < files.size(); ++f) {
+		if(!read_sizes(files[f], d[d.size() == 1 ? 0 : f])) {
+			cerr << "cannot read clone sizes from " << files[f] << endl;
+			return -1;
+		}
+	}
+
+	cout.precision(8);
+
+	if(collapse) {
+		write_collapse(cout, files, d, atof(args.option("mu-max", "5").c_str()),
+			atoi(args.option("points", "100").c_str()));
+	} else if(average) {
+		size_distribution all;
+		for(size_t f = 0; f < files.size(); ++f) {
+			size_summary s = summarise(d[f]);
+			cout << files[f] << " " << s.clones << " " << s.average() << "\n";
+			all.merge(d[f]);
+		}
+		if(files.size() > 1) {
+			size_summary s = summarise(all);
+			cout << "all " << s.clones << " " << s.average() << "\n";
+		}
+	} else if(pdf)
+		write_pdf(cout, d[0]);
+	else
+		write_cdf(cout, d[0]);
+	cout.flush();
+
+	return 0;
+}
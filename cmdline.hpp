@@ -0,0 +1,40 @@
+#ifndef CMDLINE_HPP
+#define CMDLINE_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+#include <cstring>
+
+// Splits a command line into positional arguments and options. Options are
+// written --name=value, or just --name for switches, and may appear anywhere;
+// everything else is positional, with the program name at index 0.
+struct cmdline {
+	cmdline(int argc, char ** argv) {
+		for(int i = 0; i < argc; ++i) {
+			if(i > 0 && strncmp(argv[i], "--", 2) == 0) {
+				const char * eq = strchr(argv[i], '=');
+				if(eq)
+					options[std::string(argv[i] + 2, eq - argv[i] - 2)] = eq + 1;
+				else
+					options[argv[i] + 2] = "";
+			} else
+				positional.push_back(argv[i]);
+		}
+	}
+
+	size_t size() const {return positional.size();}
+	const char * operator[](size_t i) const {return positional[i];}
+
+	bool has(const std::string & name) const {return options.count(name) > 0;}
+	std::string option(const std::string & name, const std::string & otherwise) const {
+		std::map<std::string, std::string>::const_iterator o = options.find(name);
+		return o == options.end() ? otherwise : o->second;
+	}
+
+private:
+	std::vector<const char *> positional;
+	std::map<std::string, std::string> options;
+};
+
+#endif // CMDLINE_HPP
@@ -0,0 +1,104 @@
+#ifndef COALESCING_HPP
+#define COALESCING_HPP
+
+#include <cstdint>
+#include <vector>
+#include "lattice_model.hpp"
+#include "rng.hpp"
+#include "stats.hpp"
+
+// The dual of the voter model. A cell copies a random neighbour at rate 1,
+// so following a cell's ancestry backwards from time t is a random walk
+// jumping to a random neighbour at rate 1, and two ancestries that meet stay
+// together from then on. The cells of a clone at time t are exactly those
+// whose walks, run for time t, have coalesced onto the same starting cell:
+// the label of every cell at t is the time-0 label of where its walk ends.
+//
+// uniform in [0, n): rng.below(n) wherever n fits in 32 bits, and past
+// that by rejection from the smallest power of two above n
+inline uint64_t below_wide(fast_rng & rng, uint64_t n)
+{
+	if(n <= ~uint32_t(0))
+		return rng.below(uint32_t(n));
+	const uint64_t mask = ~uint64_t(0) >> __builtin_clzll(n - 1);
+	uint64_t x;
+	do x = rng() & mask; while(x >= n);
+	return x;
+}
+
+// coalesce_walks starts a walker on every cell of l and runs them for time
+// until. Only live walkers move, one event at a time, so the cost is the
+// integral of the number of walkers left rather than N^2 * until, and at
+// long times most have merged. A walker that steps onto another merges into
+// it through a union-find over the starting cells. Then every cell of l is
+// given the label found at its walk's end, and the clone sizes are recounted.
+//
+// Walkers and cells are numbered by Index, 32 bits wherever every cell and
+// the "none" marker fit, so the walk takes half the memory it would in 64.
+template<typename Index, typename Lattice>
+void coalesce_walks_indexed(Lattice & l, double until, fast_rng & rng)
+{
+	const Index N = l.N, cells = N*N, none = ~Index(0);
+
+	// walkers are named after the cell (i*N + j) they started from
+	std::vector<Index> parent(cells), position(cells), occupant(cells), active(cells);
+	for(Index c = 0; c < cells; ++c)
+		parent[c] = position[c] = occupant[c] = active[c] = c;
+
+	// Merged walkers are left in active and dropped when picked, which
+	// still picks uniformly among the live ones; time only advances on
+	// their moves.
+	Index alive = cells;
+	for(double t = rng.exponential(alive); t < until;) {
+		const size_t k = below_wide(rng, active.size());
+		const Index w = active[k];
+		if(parent[w] != w) {
+			active[k] = active.back();
+			active.pop_back();
+			continue;
+		}
+
+		int i = position[w] / N, j = position[w] % N;
+		von_neumann_step(i, j, 1, rng);
+		l.wrap(i, j);
+		const Index to = Index(i)*N + j;
+		occupant[position[w]] = none;
+		if(occupant[to] != none) {
+			parent[w] = occupant[to];
+			alive--;
+			active[k] = active.back();
+			active.pop_back();
+		} else {
+			occupant[to] = w;
+			position[w] = to;
+		}
+		stat_count(stat_events);
+		t += rng.exponential(alive);
+	}
+
+	// the surviving walker of every cell, halving paths as they are followed,
+	// and the label where it ended; labels go in occupant, which is done with
+	for(Index c = 0; c < cells; ++c) {
+		Index r = c;
+		while(parent[r] != r) {
+			parent[r] = parent[parent[r]];
+			r = parent[r];
+		}
+		occupant[c] = l(position[r] / N, position[r] % N);
+	}
+	for(Index c = 0; c < cells; ++c)
+		l.template write<false>(c / N, c % N, occupant[c]);
+	l.time = until;
+	l.recount();
+}
+
+template<typename Lattice>
+void coalesce_walks(Lattice & l, double until, fast_rng & rng)
+{
+	if(uint64_t(l.N)*l.N < uint64_t(~uint32_t(0)))
+		coalesce_walks_indexed<uint32_t>(l, until, rng);
+	else
+		coalesce_walks_indexed<uint64_t>(l, until, rng);
+}
+
+#endif // COALESCING_HPP
@@ -0,0 +1,90 @@
+#ifndef GUT_MODEL_A_HPP
+#define GUT_MODEL_A_HPP
+
+#include <cstdint>
+#include <boost/assert.hpp>
+#include "checkpoint.hpp"
+#include "lattice_model.hpp"
+#include "rng.hpp"
+
+// A's sit at the top left corner of every 2x2 block and never move; the
+// other three cells of the block are B's. Each B stratifies at rate 1.
+struct gut_rule {
+	// the lowest bit is used to indicate A(1) or B(0); the upper 31 are a
+	// label, and 0 is an unlabelled B
+	typedef uint32_t cell_t;
+
+	uint32_t nB;
+
+	static const char * name() {return "gut_model_A";}
+	static bool labelled(cell_t c) {return c != 0;}
+	static uint32_t label(cell_t c) {return c >> 1;}
+
+	// A on the even sublattice labelled by its hilbert index, unlabelled B
+	// elsewhere
+	template<typename Lattice>
+	void initialise(Lattice & l, fast_rng &) {
+		BOOST_ASSERT(l.N%2 == 0);
+		l.fill_hilbert([](uint32_t h, int i, int j) {
+			return i % 2 == 0 && j % 2 == 0 ? (h << 1) | 0x1 : 0;
+		});
+		nB = l.N*l.N - (l.N/2)*(l.N/2);
+	}
+
+	void save(checkpoint_header & h) const {h.nB = nB;}
+	void load(const checkpoint_header & h) {nB = h.nB;}
+
+	template<typename Lattice>
+	double total_rate(const Lattice &) const {
+		BOOST_ASSERT(nB > 0);
+		return nB;
+	}
+
+	// an event touches cells up to three rows away (B, neighbouring A, and
+	// that A's neighbour A), and sublattices must keep whole 2x2 blocks
+	// together
+	static const int reach = 3;
+	static const int row_granularity = 2;
+	template<typename Lattice>
+	double rate(const Lattice & l, int begin, int end) const {return 3.0 * (end - begin)/2 * (l.N/2);}
+
+	template<bool track, typename Lattice>
+	void event(Lattice & l, int begin, int end, fast_rng & rng)
+	{
+		const size_t N = l.N;
+
+		// pick B cell in rows [begin, end): A's never move, so every 2x2 block
+		// holds an A at its top left corner and B's at the other three
+		BOOST_ASSERT(nB > 0);
+		BOOST_ASSERT(begin % 2 == 0 && end % 2 == 0);
+		int b = rng.below(3 * (end - begin)/2 * (N/2)), block = b / 3, corner = b % 3 + 1;
+		int i = begin + 2*(block / (N/2)) + (corner >> 1);
+		int j = 2*(block % (N/2)) + (corner & 0x1);
+		BOOST_ASSERT(!(l(i,j) & 0x1));
+
+		// replace with neighbouring A
+		BOOST_ASSERT(i % 2 == 1 || j % 2 == 1);
+		int ai = i, aj = j;
+		if(i % 2 == 0 && j % 2 == 1)
+			// A's should be above and below
+			aj += rng.coin() * 2 - 1;
+		else if(i % 2 == 1 && j % 2 == 0)
+			// A's should be left and right
+			ai += rng.coin() * 2 - 1;
+		else {
+			// four corners
+			ai += rng.coin() * 2 - 1;
+			aj += rng.coin() * 2 - 1;
+		}
+		l.wrap(ai, aj);
+		l.template write<track>(i, j, l(ai,aj) & (~0x1));
+
+		// replace A with neighbouring A
+		int ci = ai, cj = aj;
+		von_neumann_step(ci, cj, 2, rng);
+		l.wrap(ci, cj);
+		l.template write<track>(ai, aj, l(ci,cj));
+	}
+};
+
+#endif // GUT_MODEL_A_HPP
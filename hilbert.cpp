@@ -57,9 +57,11 @@ static uint32_t setbit(uint32_t x, uint32_t w, uint32_t i, uint32_t b)
 	else  return x & (~(1U << (w-i-1)));
 }
 
-static uint32_t bitrange(uint32_t x, uint32_t width, uint32_t start, uint32_t end)
+// bits [start, end) of x, counted from the top of its width; 64 bit so that
+// indices wider than 32 bits are not cut short
+static uint32_t bitrange(uint64_t x, uint32_t width, uint32_t start, uint32_t end)
 {
-	return x >> (width - end) & ((1 << (end - start)) - 1);
+	return x >> (width - end) & ((1U << (end - start)) - 1);
 }
 
 static uint32_t transform(uint32_t entry, uint32_t direction, uint32_t width, uint32_t x)
@@ -135,3 +137,65 @@ vector<uint32_t> hilbert_point(uint32_t dimension, uint32_t order, uint64_t h)
 	return p;
 }
 
+
+// The fast paths run the state machines of hilbert_tables (hilbert.hpp).
+static const hilbert_tables<2> & table_2d = hilbert_table<2>;
+static const uint32_t initial_state_2d = hilbert_tables<2>::index_start;
+
+uint64_t hilbert_index_2d(uint32_t order, uint32_t i, uint32_t j)
+{
+	uint64_t h = 0;
+	uint32_t s = initial_state_2d;
+	for(uint32_t k = order; k-- > 0;) {
+		uint32_t t = s*4 + (((j>>k)&1U)<<1 | ((i>>k)&1U));
+		h = (h<<2) | table_2d.digit[t];
+		s = table_2d.index_next[t];
+	}
+	return h;
+}
+
+// descend the curve one quadrant at a time, skipping quadrants outside the
+// rows x cols window; every visited leaf is written exactly once
+static void fill_2d(uint32_t s, uint32_t size, uint32_t i0, uint32_t j0, uint32_t h,
+		uint32_t rows, uint32_t cols, uint32_t * out)
+{
+	if(size == 1) {
+		out[size_t(i0)*cols + j0] = h;
+		return;
+	}
+	size >>= 1;
+	for(uint32_t l = 0; l < 4; ++l) {
+		uint32_t i = i0 + (l&1U)*size, j = j0 + (l>>1)*size;
+		if(i >= rows || j >= cols) continue;
+		uint32_t t = s*4 + l;
+		fill_2d(table_2d.index_next[t], size, i, j, (h<<2) | table_2d.digit[t], rows, cols, out);
+	}
+}
+
+bool hilbert_fill_2d(uint32_t order, uint32_t rows, uint32_t cols, uint32_t * out)
+{
+	if(order > hilbert_fill_max_order
+			|| uint64_t(rows) > (uint64_t(1) << order) || uint64_t(cols) > (uint64_t(1) << order))
+		return false;
+	if(rows == 0 || cols == 0) return true;
+	fill_2d(initial_state_2d, uint32_t(1) << order, 0, 0, 0, rows, cols, out);
+	return true;
+}
+
+static const hilbert_tables<3> & table_3d = hilbert_table<3>;
+
+boost::array<uint32_t, 3> hilbert_point_3d(uint32_t order, uint64_t h)
+{
+	BOOST_ASSERT(order <= 21);
+	boost::array<uint32_t, 3> p = {{0, 0, 0}};
+	uint32_t s = hilbert_tables<3>::point_start;
+	for(uint32_t k = order; k-- > 0;) {
+		uint32_t t = s*8 + ((h >> (3*k)) & 0x7);
+		uint32_t l = table_3d.bits[t];
+		p[0] = (p[0]<<1) | ((l>>2)&1U);
+		p[1] = (p[1]<<1) | ((l>>1)&1U);
+		p[2] = (p[2]<<1) | (l&1U);
+		s = table_3d.point_next[t];
+	}
+	return p;
+}
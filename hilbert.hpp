@@ -1,10 +1,136 @@
 #ifndef HILBERT_HPP
 #define HILBERT_HPP
 
+#include <array>
 #include <cstdint>
+#include <boost/array.hpp>
 #include <vector>
 
 uint64_t hilbert_index(uint32_t dim, uint32_t order, std::vector<uint32_t> p);
 std::vector<uint32_t> hilbert_point(uint32_t dim, uint32_t order, uint64_t h);
 
+// two dimensional fast path; identical to hilbert_index(2, order, {i, j})
+uint64_t hilbert_index_2d(uint32_t order, uint32_t i, uint32_t j);
+// Fills out[i*cols + j] = hilbert_index_2d(order, i, j) for all i < rows,
+// j < cols. The indices are 32 bits, so order is at most
+// hilbert_fill_max_order; returns false, writing nothing, for a larger order
+// or a window bigger than the curve.
+static const uint32_t hilbert_fill_max_order = 16;
+bool hilbert_fill_2d(uint32_t order, uint32_t rows, uint32_t cols, uint32_t * out);
+
+// three dimensional fast path; identical to hilbert_point(3, order, h), for
+// order up to 21
+boost::array<uint32_t, 3> hilbert_point_3d(uint32_t order, uint64_t h);
+
+// The (entry, direction) pair carried from one level of the curve to the next
+// takes only 2^Dim * Dim values, so both loops of hilbert_index and
+// hilbert_point are finite state machines. These are their transition tables,
+// worked out at compile time with the same steps as hilbert.cpp.
+template<unsigned Dim>
+struct hilbert_tables {
+	static_assert(Dim >= 2 && Dim <= 5, "hilbert_tables: 2 to 5 dimensions");
+	static const unsigned cells = 1U << Dim;        // children of a cube
+	static const unsigned states = cells * Dim;     // state = entry*Dim + direction
+	static const unsigned index_start = 1;          // entry 0, direction 1
+	static const unsigned point_start = 0;          // entry 0, direction 0
+
+	// encoding, by state*cells + l where bit x of l is the bit of coordinate x:
+	// the digit of the index, and the next state
+	std::array<uint8_t, states * cells> digit, index_next;
+	// decoding, by state*cells + digit: l, with the bit of coordinate j in bit
+	// Dim-1-j, and the next state
+	std::array<uint8_t, states * cells> bits, point_next;
+
+	constexpr hilbert_tables(): digit(), index_next(), bits(), point_next() {
+		for(unsigned e = 0; e < cells; ++e) {
+			for(unsigned d = 0; d < Dim; ++d) {
+				for(unsigned x = 0; x < cells; ++x) {
+					const unsigned s = (e*Dim + d)*cells + x;
+					const unsigned w = igraycode(rrot(x ^ e, d + 1));
+					digit[s] = w;
+					index_next[s] = next(e, d, w);
+					bits[s] = lrot(graycode(x), d + 1) ^ e;
+					point_next[s] = next(e, d, x);
+				}
+			}
+		}
+	}
+
+private:
+	static constexpr unsigned graycode(unsigned x) {return x ^ (x >> 1);}
+	static constexpr unsigned igraycode(unsigned x) {
+		for(unsigned shift = 1; shift < 32; shift <<= 1) x ^= x >> shift;
+		return x;
+	}
+	static constexpr unsigned rrot(unsigned x, unsigned i) {
+		i %= Dim;
+		return ((x >> i) | (x << (Dim - i))) & (cells - 1);
+	}
+	static constexpr unsigned lrot(unsigned x, unsigned i) {
+		i %= Dim;
+		return ((x << i) | (x >> (Dim - i))) & (cells - 1);
+	}
+	// trailing set bits
+	static constexpr unsigned tsb(unsigned x) {
+		unsigned i = 0;
+		while(x & 1) {x >>= 1; i++;}
+		return i;
+	}
+	static constexpr unsigned direction(unsigned w) {
+		return w == 0 ? 0 : (w % 2 == 0 ? tsb(w - 1) : tsb(w)) % Dim;
+	}
+	static constexpr unsigned entry(unsigned w) {return w == 0 ? 0 : graycode(2*((w - 1)/2));}
+	static constexpr unsigned next(unsigned e, unsigned d, unsigned w) {
+		return (e ^ lrot(entry(w), d + 1))*Dim + (d + direction(w) + 1) % Dim;
+	}
+};
+
+// one copy of each, shared by every order
+template<unsigned Dim>
+inline constexpr hilbert_tables<Dim> hilbert_table = hilbert_tables<Dim>();
+
+// The hilbert curve with Dim dimensions and Order bits per coordinate, with
+// the whole index in 64 bits (so up to order 32 in two dimensions and 21 in
+// three). index(p) is hilbert_index(Dim, Order, p) and point(h) is
+// hilbert_point(Dim, Order, h), wherever those do not overflow, but with
+// Order fixed at compile time and nothing per level but shifts and table
+// lookups. As with those, point inverts index in two dimensions only; in
+// three the decoder starts from another state, which the palette's colours
+// depend on.
+template<unsigned Dim, unsigned Order>
+struct hilbert {
+	static_assert(Order >= 1 && Order <= 32 && Dim*Order <= 64,
+		"hilbert: the index must fit in 64 bits");
+	typedef std::array<uint32_t, Dim> point_t;
+	typedef hilbert_tables<Dim> tables_t;
+	static constexpr const tables_t & tables = hilbert_table<Dim>;
+
+	static constexpr uint64_t index(const point_t & p) {
+		uint64_t h = 0;
+		unsigned s = tables_t::index_start;
+		for(unsigned k = Order; k-- > 0;) {
+			unsigned l = 0;
+			for(unsigned x = 0; x < Dim; ++x)
+				l |= ((p[x] >> k) & 1U) << x;
+			const unsigned t = s*tables_t::cells + l;
+			h = (h << Dim) | tables.digit[t];
+			s = tables.index_next[t];
+		}
+		return h;
+	}
+
+	static constexpr point_t point(uint64_t h) {
+		point_t p = {};
+		unsigned s = tables_t::point_start;
+		for(unsigned k = Order; k-- > 0;) {
+			const unsigned t = s*tables_t::cells + ((h >> (Dim*k)) & (tables_t::cells - 1));
+			const unsigned l = tables.bits[t];
+			for(unsigned j = 0; j < Dim; ++j)
+				p[j] = (p[j] << 1) | ((l >> (Dim - 1 - j)) & 1U);
+			s = tables.point_next[t];
+		}
+		return p;
+	}
+};
+
 #endif // HILBERT_HPP
@@ -0,0 +1,100 @@
+/* Checks the compile-time hilbert<Dim, Order> against the runtime curve:
+ * index and point of hilbert<2,16>, <2,32>, <3,21> and <4,4> must match
+ * hilbert_index and hilbert_point (and the fast paths hilbert_index_2d and
+ * hilbert_point_3d), and in two dimensions point must invert index. Points
+ * are random, from a fixed seed, except for <4,4>, which is checked over its
+ * whole range. hilbert_fill_2d must agree with hilbert_index_2d.
+*/
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "hilbert.hpp"
+#include "replicas.hpp"
+#include "rng.hpp"
+
+// both usable in constant expressions
+static_assert(hilbert<2, 4>::index(hilbert<2, 4>::point(200)) == 200, "hilbert: constexpr round trip");
+static_assert(hilbert<3, 21>::point(123456789012345ULL)[0] < (1U << 21), "hilbert: constexpr point");
+
+uint64_t failures = 0;
+
+void expect(bool ok, const std::string & what, uint64_t h)
+{
+	if(!ok && failures++ < 10)
+		std::cout << "  FAILED " << what << " at index " << h << std::endl;
+}
+
+template<unsigned Order>
+void check_2d(fast_rng & rng, uint64_t samples)
+{
+	typedef hilbert<2, Order> curve;
+	const uint32_t mask = Order == 32 ? ~uint32_t(0) : (uint32_t(1) << Order) - 1;
+	for(uint64_t k = 0; k < samples; ++k) {
+		const uint32_t i = rng() & mask, j = rng() & mask;
+		const uint64_t h = curve::index({{i, j}});
+		expect(h == hilbert_index(2, Order, {i, j}), "index = hilbert_index", h);
+		expect(h == hilbert_index_2d(Order, i, j), "index = hilbert_index_2d", h);
+		const typename curve::point_t p = curve::point(h);
+		expect(p[0] == i && p[1] == j, "point(index(p)) = p", h);
+		expect(std::vector<uint32_t>(p.begin(), p.end()) == hilbert_point(2, Order, h),
+			"point = hilbert_point", h);
+	}
+	std::cout << "hilbert<2," << Order << ">: " << samples << " points" << std::endl;
+}
+
+void check_3d(fast_rng & rng, uint64_t samples)
+{
+	typedef hilbert<3, 21> curve;
+	for(uint64_t k = 0; k < samples; ++k) {
+		const uint64_t h = rng() >> 1;
+		const curve::point_t p = curve::point(h);
+		const std::vector<uint32_t> v(p.begin(), p.end());
+		expect(v == hilbert_point(3, 21, h), "point = hilbert_point", h);
+		const boost::array<uint32_t, 3> fast = hilbert_point_3d(21, h);
+		expect(std::vector<uint32_t>(fast.begin(), fast.end()) == v, "point = hilbert_point_3d", h);
+		expect(curve::index(p) == hilbert_index(3, 21, v), "index = hilbert_index", h);
+	}
+	std::cout << "hilbert<3,21>: " << samples << " points" << std::endl;
+}
+
+void check_4d()
+{
+	typedef hilbert<4, 4> curve;
+	for(uint64_t h = 0; h < (uint64_t(1) << 16); ++h) {
+		const curve::point_t p = curve::point(h);
+		const std::vector<uint32_t> v(p.begin(), p.end());
+		expect(v == hilbert_point(4, 4, h), "point = hilbert_point", h);
+		expect(curve::index(p) == hilbert_index(4, 4, v), "index = hilbert_index", h);
+	}
+	std::cout << "hilbert<4,4>: every index" << std::endl;
+}
+
+// hilbert_fill_2d on a window that is not square, and its refusals
+void check_fill()
+{
+	const uint32_t order = 6, rows = 40, cols = 64;
+	std::vector<uint32_t> out(rows * cols + 1, ~uint32_t(0));
+	expect(hilbert_fill_2d(order, rows, cols, &out[0]), "hilbert_fill_2d accepts a window", 0);
+	for(uint32_t i = 0; i < rows; ++i)
+		for(uint32_t j = 0; j < cols; ++j)
+			expect(out[i*cols + j] == hilbert_index_2d(order, i, j), "fill = hilbert_index_2d", out[i*cols + j]);
+	expect(out[rows * cols] == ~uint32_t(0), "fill stays in its window", rows * cols);
+	expect(!hilbert_fill_2d(hilbert_fill_max_order + 1, 1, 1, &out[0]), "fill refuses a large order", 0);
+	expect(!hilbert_fill_2d(order, rows, 65, &out[0]), "fill refuses a window bigger than the curve", 0);
+	std::cout << "hilbert_fill_2d: " << rows << " x " << cols << " of order " << order << std::endl;
+}
+
+int main()
+{
+	fast_rng rng;
+	seed_replica(rng, 1, 0);
+	check_2d<16>(rng, 100000);
+	check_2d<32>(rng, 100000);
+	check_3d(rng, 100000);
+	check_4d();
+	check_fill();
+	std::cout << failures << " failures" << std::endl;
+	return failures == 0 ? 0 : 1;
+}
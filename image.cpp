@@ -0,0 +1,218 @@
+#include "image.hpp"
+#include <boost/assert.hpp>
+#include <cstdio>
+
+using namespace std;
+
+bool parse_image_format(const string & name, const string & filename, image_format & format)
+{
+	if(name == "p3")
+		format = image_p3;
+	else if(name == "p6" || name == "ppm")
+		format = image_p6;
+	else if(name == "png")
+		format = image_png;
+	else if(!name.empty())
+		return false;
+	else if(filename.size() >= 4 && filename.compare(filename.size() - 4, 4, ".png") == 0)
+		format = image_png;
+	else
+		format = image_p6;
+	return true;
+}
+
+static void put_u32(vector<uint8_t> & v, uint32_t x)
+{
+	v.push_back(x >> 24);
+	v.push_back(x >> 16);
+	v.push_back(x >> 8);
+	v.push_back(x);
+}
+
+static uint32_t crc32(uint32_t crc, const uint8_t * data, size_t n)
+{
+	static uint32_t table[256];
+	static bool initialised = false;
+	if(!initialised) {
+		for(uint32_t i = 0; i < 256; ++i) {
+			uint32_t c = i;
+			for(int k = 0; k < 8; ++k)
+				c = (c & 1) ? 0xedb88320U ^ (c >> 1) : c >> 1;
+			table[i] = c;
+		}
+		initialised = true;
+	}
+	crc = ~crc;
+	for(size_t i = 0; i < n; ++i)
+		crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+	return ~crc;
+}
+
+image_writer::image_writer(const char * filename, uint32_t width_, uint32_t height_, image_format format_):
+	file(filename, ios::binary), width(width_), height(height_), format(format_), rows_written(0),
+	buffer(1 + 3*width), bits(0), nbits(0), adler_a(1), adler_b(0)
+{
+	switch(format) {
+	case image_p3:
+	case image_p6: {
+		char header[64];
+		int n = snprintf(header, sizeof(header), "%s\n%u %u\n255\n",
+			format == image_p3 ? "P3" : "P6", width, height);
+		file.write(header, n);
+		break;
+	}
+	case image_png: {
+		static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+		file.write(reinterpret_cast<const char *>(signature), 8);
+		put_u32(chunk, width);
+		put_u32(chunk, height);
+		chunk.push_back(8); // bit depth
+		chunk.push_back(2); // truecolour
+		chunk.push_back(0); // deflate
+		chunk.push_back(0); // adaptive filtering
+		chunk.push_back(0); // not interlaced
+		write_chunk("IHDR");
+		// zlib header: deflate with a 32k window, no dictionary
+		chunk.push_back(0x78);
+		chunk.push_back(0x01);
+		break;
+	}
+	}
+}
+
+image_writer::~image_writer()
+{
+	BOOST_ASSERT(rows_written == height);
+	if(format == image_png)
+		write_chunk("IEND");
+}
+
+void image_writer::write_row()
+{
+	BOOST_ASSERT(rows_written < height);
+	++rows_written;
+	switch(format) {
+	case image_p3: {
+		text.clear();
+		char number[8];
+		for(uint32_t k = 0; k < 3*width; ++k) {
+			int n = snprintf(number, sizeof(number), "%u ", buffer[k+1]);
+			text.append(number, n);
+		}
+		text += '\n';
+		file.write(text.data(), text.size());
+		break;
+	}
+	case image_p6:
+		file.write(reinterpret_cast<const char *>(&buffer[1]), 3*width);
+		break;
+	case image_png:
+		buffer[0] = 0; // no filter
+		deflate_row();
+		break;
+	}
+}
+
+void image_writer::put_bits(uint32_t value, uint32_t n)
+{
+	bits |= uint64_t(value) << nbits;
+	nbits += n;
+	while(nbits >= 8) {
+		chunk.push_back(bits & 0xff);
+		bits >>= 8;
+		nbits -= 8;
+	}
+}
+
+// huffman codes are packed starting from their most significant bit
+void image_writer::put_huffman(uint32_t code, uint32_t n)
+{
+	uint32_t r = 0;
+	for(uint32_t i = 0; i < n; ++i)
+		r |= ((code >> i) & 1U) << (n - i - 1);
+	put_bits(r, n);
+}
+
+// fixed huffman literal/length alphabet (RFC 1951, 3.2.6)
+void image_writer::put_literal(uint32_t literal)
+{
+	if(literal < 144)      put_huffman(0x30 + literal, 8);
+	else if(literal < 256) put_huffman(0x190 + literal - 144, 9);
+	else if(literal < 280) put_huffman(literal - 256, 7);
+	else                   put_huffman(0xc0 + literal - 280, 8);
+}
+
+// a copy of the pixel immediately before, i.e. distance 3
+void image_writer::put_match(uint32_t length)
+{
+	static const uint16_t base[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23,
+		27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+	static const uint8_t extra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2,
+		2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+	BOOST_ASSERT(length >= 3 && length <= 258);
+	uint32_t k = 28;
+	while(base[k] > length) --k;
+	put_literal(257 + k);
+	put_bits(length - base[k], extra[k]);
+	put_huffman(2, 5);
+}
+
+// Each row becomes one fixed-huffman block. Clone pictures are mostly runs of
+// a single colour, so matching only against the previous pixel captures most
+// of what a general LZ77 search would.
+void image_writer::deflate_row()
+{
+	const uint8_t * data = &buffer[0];
+	const uint32_t n = buffer.size();
+
+	put_bits(rows_written == height ? 1 : 0, 1); // final block?
+	put_bits(1, 2); // fixed huffman codes
+	uint32_t p = 0;
+	while(p < n) {
+		uint32_t length = 0;
+		if(p >= 3) {
+			while(p + length < n && length < 258 && data[p + length] == data[p + length - 3])
+				++length;
+		}
+		if(length >= 3) {
+			put_match(length);
+			p += length;
+		} else
+			put_literal(data[p++]);
+	}
+	put_literal(256); // end of block
+
+	// largest n such that the sums cannot overflow 32 bits before the modulus
+	for(uint32_t start = 0; start < n; start += 5552) {
+		uint32_t end = min(n, start + 5552);
+		for(uint32_t k = start; k < end; ++k) {
+			adler_a += data[k];
+			adler_b += adler_a;
+		}
+		adler_a %= 65521;
+		adler_b %= 65521;
+	}
+
+	if(rows_written == height) {
+		if(nbits > 0) put_bits(0, 8 - nbits);
+		put_u32(chunk, adler_b << 16 | adler_a);
+	}
+	write_chunk("IDAT");
+}
+
+void image_writer::write_chunk(const char * type)
+{
+	uint8_t length[4] = {
+		uint8_t(chunk.size() >> 24), uint8_t(chunk.size() >> 16),
+		uint8_t(chunk.size() >> 8), uint8_t(chunk.size())};
+	file.write(reinterpret_cast<const char *>(length), 4);
+	file.write(type, 4);
+	if(!chunk.empty())
+		file.write(reinterpret_cast<const char *>(&chunk[0]), chunk.size());
+	uint32_t crc = crc32(0, reinterpret_cast<const uint8_t *>(type), 4);
+	if(!chunk.empty())
+		crc = crc32(crc, &chunk[0], chunk.size());
+	uint8_t c[4] = {uint8_t(crc >> 24), uint8_t(crc >> 16), uint8_t(crc >> 8), uint8_t(crc)};
+	file.write(reinterpret_cast<const char *>(c), 4);
+	chunk.clear();
+}
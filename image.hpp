@@ -0,0 +1,57 @@
+#ifndef IMAGE_HPP
+#define IMAGE_HPP
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+enum image_format {
+	image_p3,  // plain text PPM
+	image_p6,  // binary PPM
+	image_png  // PNG, deflated without zlib
+};
+
+// "p3", "p6" (or "ppm") and "png"; an empty name picks png for *.png
+// filenames and p6 otherwise. Returns false for any other name.
+bool parse_image_format(const std::string & name, const std::string & filename, image_format & format);
+
+// Streams an RGB picture to disk one row at a time. Fill row() with width
+// pixels (three bytes each) and call write_row(), height times; the row
+// buffer is reused throughout.
+class image_writer {
+public:
+	image_writer(const char * filename, uint32_t width, uint32_t height, image_format format);
+	~image_writer();
+
+	uint8_t * row() {return &buffer[1];}
+	void write_row();
+
+private:
+	image_writer(const image_writer &);
+	image_writer & operator=(const image_writer &);
+
+	std::ofstream file;
+	const uint32_t width, height;
+	const image_format format;
+	uint32_t rows_written;
+
+	// pixels, preceded by the png filter type byte
+	std::vector<uint8_t> buffer;
+	std::string text;
+
+	// png state: bits not yet written out, and the zlib checksum
+	std::vector<uint8_t> chunk;
+	uint64_t bits;
+	uint32_t nbits;
+	uint32_t adler_a, adler_b;
+
+	void put_bits(uint32_t value, uint32_t n);
+	void put_huffman(uint32_t code, uint32_t n);
+	void put_literal(uint32_t literal);
+	void put_match(uint32_t length);
+	void deflate_row();
+	void write_chunk(const char * type);
+};
+
+#endif // IMAGE_HPP
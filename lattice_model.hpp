@@ -0,0 +1,246 @@
+#ifndef LATTICE_MODEL_HPP
+#define LATTICE_MODEL_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <boost/assert.hpp>
+#include "checkpoint.hpp"
+#include "clone_sizes.hpp"
+#include "hilbert.hpp"
+#include "image.hpp"
+#include "layout.hpp"
+#include "palette.hpp"
+#include "rng.hpp"
+#include "stats.hpp"
+
+// How a lattice of side N wraps around. Neighbour lookups wrap on every
+// event, and a remainder by a runtime N costs a division each time: any_size
+// compares instead, and pow2_size fixes N to a power of two at compile time,
+// so that wrapping is a mask.
+struct any_size {
+	static bool fits(size_t) {return true;}
+	static int wrap(int i, int N) {
+		// precondition: -N <= i < 2N
+		return i < 0 ? i + N : i >= N ? i - N : i;
+	}
+};
+
+template<unsigned LogN>
+struct pow2_size {
+	static const int side = 1 << LogN;
+	static bool fits(size_t N) {return N == side;}
+	static int wrap(int i, int) {return i & (side - 1);}
+};
+
+// Calls f(pow2_size<k>()) if N is 2^k for k in [LogN, 13], and f(any_size())
+// otherwise, so that each power of two from 64 to 8192 gets its own
+// instantiation of f.
+template<unsigned LogN = 6, typename F>
+int with_lattice_size(size_t N, F f)
+{
+	if(N == size_t(1) << LogN)
+		return f(pow2_size<LogN>());
+	if constexpr(LogN < 13)
+		return with_lattice_size<LogN + 1>(N, f);
+	else
+		return f(any_size());
+}
+
+// The largest side of a label_lattice. Rules number sites, labels and clone
+// counts in 32 bits, some with the label shifted up past an A bit, and the
+// gut and AB rules count and pick among 3N^2/4 or N^2 cells in an int, so
+// N^2 must stay below 2^31.
+static const size_t max_lattice_side = size_t(1) << 15;
+
+// A kinetic Monte Carlo model on an N x N periodic lattice of labelled cells,
+// stored in Layout and wrapped around as Size says, whose dynamics are given
+// by Rule. The lattice keeps the
+// cells, the clock and the clone sizes, and does the checkpoints, pictures
+// and sublattice bookkeeping; the rule only says what an event does. All of
+// a rule's hooks are inlined into the event loop.
+//
+// A Rule provides
+//   cell_t                  what a cell holds
+//   name()                  the model, for checkpoints and output
+//   labelled(c), label(c)   whether cell c belongs to a clone, and which
+//   initialise(lattice, rng)
+//                           the starting cells
+//   total_rate(lattice)     rate of all events
+//   event<track>(lattice, begin, end, rng)
+//                           one event starting uniformly in rows [begin, end);
+//                           it writes cells through lattice.write<track>, and
+//                           may return a count for simulate_lattice to tally
+// and, for run_sublattice,
+//   reach, row_granularity  as in sublattice.hpp; row_granularity 0 if none
+//   rate(lattice, begin, end)
+// and, for checkpoints, save(h) and load(h) of any state of its own.
+// Optionally, prepare(lattice, rng, run) gets a new lattice ready before its
+// clock starts, where run(until) runs events up to time until.
+// Optionally, dual(lattice, until, rng) samples the lattice at time until
+// directly, for --dual.
+template<typename Rule, typename Layout, typename Size = any_size>
+class label_lattice {
+public:
+	typedef typename Rule::cell_t cell_t;
+
+	double time;
+	const size_t N;
+	Rule rule;
+
+	label_lattice(size_t N_, fast_rng & rng): time(0.0), N(N_), g(N) {
+		BOOST_ASSERT(Size::fits(N) && N <= max_lattice_side);
+		rule.initialise(*this, rng);
+		recount();
+	}
+
+	// continue from a checkpoint, using its cells where they are mapped
+	explicit label_lattice(const checkpoint & c): time(c.header().time), N(c.header().N),
+			g(N, c.cells(), c.mapping()) {
+		BOOST_ASSERT(Size::fits(N));
+		rule.load(c.header());
+		recount();
+	}
+
+	static bool can_resume(const checkpoint & c) {
+		const checkpoint_header & h = c.header();
+		return strncmp(h.model, Rule::name(), sizeof(h.model)) == 0
+			&& strncmp(h.layout, Layout::name(), sizeof(h.layout)) == 0
+			&& h.rng_bytes == sizeof(fast_rng)
+			&& h.cells == Layout(h.N).size();
+	}
+
+	bool save(const std::string & filename, uint32_t seed, const fast_rng & rng) const {
+		checkpoint_header h = make_checkpoint_header(Rule::name(), Layout::name(), N);
+		h.time = time;
+		h.seed = seed;
+		rule.save(h);
+		return save_checkpoint(filename, h, &rng, sizeof(rng), g.data(), g.size());
+	}
+
+	cell_t & operator()(int i, int j) {return g(i,j);}
+	const cell_t & operator()(int i, int j) const {return g(i,j);}
+
+	// overwrite a cell, keeping the clone sizes up to date if track
+	template<bool track>
+	void write(int i, int j, cell_t v) {
+		cell_t & c = g(i,j);
+		if(c == v) stat_count(stat_noop_writes);
+		if(track) {
+			const bool was = Rule::labelled(c), is = Rule::labelled(v);
+			if(was && is)
+				sizes.move(Rule::label(c), Rule::label(v));
+			else {
+				if(was) sizes.remove(Rule::label(c));
+				if(is) sizes.add(Rule::label(v));
+			}
+		}
+		c = v;
+	}
+
+	void wrap(int & i, int & j) const {
+		// precondition: -N <= i,j < 2N
+		i = Size::wrap(i, N);
+		j = Size::wrap(j, N);
+	}
+
+	// one event anywhere, and the time to the next
+	auto stratify_cell(fast_rng & rng) {return rule.template event<true>(*this, 0, N, rng);}
+	double next_event(fast_rng & rng) const {return rng.exponential(rule.total_rate(*this));}
+
+	// for run_sublattice. Events on several threads at once would race on
+	// the clone sizes, so these leave them to recount().
+	static const int reach = Rule::reach;
+	static const int row_granularity = Rule::row_granularity;
+	double rate(int begin, int end) const {return rule.rate(*this, begin, end);}
+	void stratify_cell(int begin, int end, fast_rng & rng) {rule.template event<false>(*this, begin, end, rng);}
+
+	void recount() {
+		stat_scope timer(stat_recount);
+		sizes.clear();
+		for(int i = 0; i < N; ++i) {
+			for(int j = 0; j < N; ++j) {
+				if(Rule::labelled(g(i,j)))
+					sizes.add(Rule::label(g(i,j)));
+			}
+		}
+	}
+
+	const clone_histogram & histogram() const {return sizes;}
+
+	// Fills the lattice with initial(h, i, j) for the hilbert index h of
+	// every cell. The cells are worked out once per grid size and shared by
+	// all replicas, already in storage order.
+	template<typename Initial>
+	void fill_hilbert(Initial initial) {
+		static std::mutex cache_mutex;
+		static std::map<size_t, std::vector<cell_t> > cache;
+		std::lock_guard<std::mutex> lock(cache_mutex);
+		std::vector<cell_t> & cells = cache[N];
+		if(cells.empty()) {
+			std::vector<uint32_t> h(N*N);
+			BOOST_VERIFY(hilbert_fill_2d(ceil(log(N) / log(2)), N, N, &h[0]));
+			lattice_storage<cell_t, Layout> image(N);
+			for(int i = 0; i < N; ++i) {
+				for(int j = 0; j < N; ++j)
+					image(i,j) = initial(h[i*N + j], i, j);
+			}
+			cells.assign(image.data(), image.data() + image.size());
+		}
+		memcpy(g.data(), &cells[0], g.size()*sizeof(cell_t));
+	}
+
+	// unlabelled cells are black
+	void save_picture(const char * filename, image_format format) const {
+		static label_palette palette; // only replica 0 draws
+		image_writer file(filename, N, N, format);
+		for(int i = 0; i < N; ++i) {
+			uint8_t * row = file.row();
+			for(int j = 0; j < N; ++j) {
+				if(Rule::labelled(g(i,j))) {
+					label_palette::rgb_t rgb = palette(Rule::label(g(i,j)));
+					*row++ = rgb[0]; *row++ = rgb[1]; *row++ = rgb[2];
+				} else {
+					*row++ = 0; *row++ = 0; *row++ = 0;
+				}
+			}
+			file.write_row();
+		}
+	}
+
+	friend std::ostream & operator<<(std::ostream & os, const label_lattice & l)
+	{
+		for(int i = 0; i < l.N; ++i) {
+			for(int j = 0; j < l.N; ++j)
+				os << l.g(i,j) << " ";
+			os << std::endl;
+		}
+		return os;
+	}
+
+private:
+	lattice_storage<cell_t, Layout> g;
+	// cells per label, kept up to date by write<true>
+	clone_histogram sizes;
+};
+
+// Moves (i,j) by stride to one of its four nearest neighbours at that
+// distance, each with probability 1/4.
+inline void von_neumann_step(int & i, int & j, int stride, fast_rng & rng)
+{
+	if(rng.coin()) i += stride*(rng.coin() * 2 - 1);
+	else           j += stride*(rng.coin() * 2 - 1);
+}
+
+// for rules with no state of their own to checkpoint
+struct stateless_rule {
+	void save(checkpoint_header &) const {}
+	void load(const checkpoint_header &) {}
+};
+
+#endif // LATTICE_MODEL_HPP
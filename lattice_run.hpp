@@ -0,0 +1,289 @@
+#ifndef LATTICE_RUN_HPP
+#define LATTICE_RUN_HPP
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "checkpoint.hpp"
+#include "clone_output.hpp"
+#include "clone_sizes.hpp"
+#include "cmdline.hpp"
+#include "image.hpp"
+#include "lattice_model.hpp"
+#include "layout.hpp"
+#include "model_options.hpp"
+#include "observations.hpp"
+#include "replicas.hpp"
+#include "rng.hpp"
+#include "stats.hpp"
+#include "sublattice.hpp"
+
+// whether Rule has a dual(lattice, until, rng), which sets a lattice at time
+// 0 to a sample of the model at time until without running its events
+template<typename Rule, typename Lattice, typename = void>
+struct has_dual: std::false_type {};
+template<typename Rule, typename Lattice>
+struct has_dual<Rule, Lattice, std::void_t<decltype(std::declval<Rule &>().dual(
+	std::declval<Lattice &>(), 0.0, std::declval<fast_rng &>()))> >: std::true_type {};
+
+// whether Rule has prepare(lattice, rng, run), as in lattice_model.hpp
+template<typename Rule, typename Lattice, typename = void>
+struct has_prepare: std::false_type {};
+template<typename Rule, typename Lattice>
+struct has_prepare<Rule, Lattice, std::void_t<decltype(std::declval<Rule &>().prepare(
+	std::declval<Lattice &>(), std::declval<fast_rng &>(),
+	std::declval<const std::function<void(double)> &>()))> >: std::true_type {};
+
+// whether Rule can be checkpointed, having save(h) and load(h)
+template<typename Rule, typename = void>
+struct has_checkpoint: std::false_type {};
+template<typename Rule>
+struct has_checkpoint<Rule, std::void_t<decltype(std::declval<Rule &>().load(
+	std::declval<const checkpoint_header &>()))> >: std::true_type {};
+
+// whether the events of Lattice return a count, for --walks
+template<typename Lattice>
+constexpr bool counts_events = !std::is_void<decltype(
+	std::declval<Lattice &>().stratify_cell(std::declval<fast_rng &>()))>::value;
+
+// The command line of a model on a label_lattice:
+//   <grid size> <time> <runs> [picture] [options]
+// runs that many replicas to the given time, writing the clone sizes of each
+// to standard output and, if asked for, a picture of the first.
+template<typename Rule, typename Layout, typename Size>
+int simulate_lattice(const cmdline & args, image_format format, clone_format clones)
+{
+	using namespace std;
+	typedef label_lattice<Rule, Layout, Size> lattice;
+
+	uint32_t seed = run_seed(args);
+	const int runs = atoi(args[3]);
+
+	// with --domains, each lattice is itself split over that many threads
+	const int domains = atoi(args.option("domains", "1").c_str());
+	const double tau = atof(args.option("tau", "0.25").c_str());
+	if(domains > 1 && !sublattice_fits<lattice>(atoi(args[1]), domains)) {
+		cerr << "cannot run grid size " << args[1] << " on " << domains << " domains" << endl;
+		return -1;
+	}
+
+	// with --checkpoint=file the run is saved there every --checkpoint-every
+	// seconds (default 600), and --resume=file carries on from such a save
+	// exactly as if it had never stopped
+	const string checkpoint_file = args.option("checkpoint", "");
+	const double checkpoint_every = atof(args.option("checkpoint-every", "600").c_str());
+	std::unique_ptr<checkpoint> resume;
+	if(args.has("resume")) {
+		resume.reset(new checkpoint(args.option("resume", "")));
+		if(!resume->ok() || !lattice::can_resume(*resume)
+				|| resume->header().N != atoi(args[1])) {
+			cerr << "cannot resume from " << args.option("resume", "")
+				<< " with grid size " << args[1] << " and layout " << Layout::name() << endl;
+			return -1;
+		}
+		seed = resume->header().seed;
+	}
+	if((resume || !checkpoint_file.empty())
+			&& (!has_checkpoint<Rule>::value || runs != 1 || domains > 1)) {
+		cerr << "checkpoints need a model that saves its state, and a single run"
+			" on a single domain" << endl;
+		return -1;
+	}
+
+	// with --times=t1,t2,..., each lattice is also observed at those times on
+	// its way to <time>, so a whole series costs no more than its last point.
+	// Every observation writes its clone sizes to its own file, named after
+	// --times-prefix (by default the picture without its extension, or else
+	// <model>-<grid size>): at time 16, with prefix pv, to pv-16.txt
+	// (pv-16.clones if binary). Only if there is a picture is one drawn at
+	// every observation too, as pv-16.png for pv.png. Observations before a
+	// resumed checkpoint are not repeated.
+	const bool picture = args.size() > 4;
+	const bool series = args.has("times");
+	string prefix = args.option("times-prefix", "");
+	if(prefix.empty())
+		prefix = picture ? string(args[4]).substr(0, extension_start(args[4]))
+			: string(Rule::name()) + "-" + args[1];
+	const string extension = clones == clones_binary ? ".clones" : ".txt";
+	const vector<double> times = observation_times(args.option("times", ""),
+		resume ? resume->header().time : 0, atof(args[2]));
+	if(times.empty()) {
+		cerr << "cannot read observation times " << args.option("times", "") << endl;
+		return -1;
+	}
+	vector<string> pictures;
+	vector<std::unique_ptr<ofstream> > files;
+	vector<std::ostream *> streams;
+	for(size_t k = 0; k < times.size(); ++k) {
+		if(series) {
+			if(picture)
+				pictures.push_back(observation_name(prefix, times[k],
+					string(args[4]).substr(extension_start(args[4]))));
+			const string name = observation_name(prefix, times[k], extension);
+			files.emplace_back(new ofstream(name.c_str(), ios::binary));
+			if(!*files.back()) {
+				cerr << "cannot write " << name << endl;
+				return -1;
+			}
+			streams.push_back(files.back().get());
+		} else {
+			if(picture)
+				pictures.push_back(args[4]);
+			streams.push_back(&std::cout);
+		}
+	}
+
+	// with --dual, for models that have one, each replica is sampled at
+	// <time> from the dual process instead of being run event by event
+	const bool dual = args.has("dual");
+	if(dual && (!has_dual<Rule, lattice>::value || domains > 1 || series
+			|| resume || !checkpoint_file.empty())) {
+		cerr << "--dual needs a model with a dual process, and no --domains,"
+			" --times or checkpoints" << endl;
+		return -1;
+	}
+
+	// with --walks=file, for models whose events return a count (the
+	// vacancy hops of mc_2d_AB_stratify), the counts are tallied per replica
+	// and written there as "replica count events" lines
+	const string walks_file = args.option("walks", "");
+	vector<size_distribution> walks(walks_file.empty() || !counts_events<lattice> ? 0 : runs);
+
+	model_options options(args, Rule::name(), clones, seed, times.size());
+	for(size_t k = 0; k < times.size(); ++k)
+		options.writer.header(*streams[k], times[k]);
+
+	run_replicas(runs, options.threads, [&](int i, vector<std::ostringstream> & out) {
+		fast_rng rng;
+		seed_replica(rng, seed, i);
+		lattice grid = [&]() {
+			if constexpr(has_checkpoint<Rule>::value)
+				if(resume) return lattice(*resume);
+			return lattice(atoi(args[1]), rng);
+		}();
+		chrono::steady_clock::time_point saved = chrono::steady_clock::now();
+		uint64_t events = 0;
+
+		// events one at a time until the given time
+		auto run = [&](double until) {
+			while(grid.time < until) {
+				if constexpr(counts_events<lattice>) {
+					const uint32_t count = grid.stratify_cell(rng);
+					if(!walks.empty()) walks[i].add(count);
+				} else
+					grid.stratify_cell(rng);
+				grid.time += grid.next_event(rng);
+				stat_count(stat_events);
+				// only look at the clock every million or so events
+				if constexpr(has_checkpoint<Rule>::value) {
+					if(!checkpoint_file.empty() && (++events & 0xfffff) == 0
+							&& chrono::steady_clock::now() - saved > chrono::duration<double>(checkpoint_every)) {
+						stat_scope timer(stat_checkpoint);
+						if(!grid.save(checkpoint_file, seed, rng))
+							cerr << "could not write checkpoint " << checkpoint_file << endl;
+						saved = chrono::steady_clock::now();
+					}
+				}
+			}
+		};
+
+		if(resume)
+			memcpy(&rng, resume->rng(), sizeof(rng));
+		else {
+			if constexpr(has_prepare<Rule, lattice>::value)
+				grid.rule.prepare(grid, rng, run);
+			if(domains == 1 && !dual)
+				grid.time += grid.next_event(rng);
+		}
+
+		for(size_t k = 0; k < times.size(); ++k) {
+			if(dual) {
+				if constexpr(has_dual<Rule, lattice>::value)
+					grid.rule.dual(grid, times[k], rng);
+			} else if(domains > 1) {
+				if constexpr(lattice::row_granularity > 0)
+					run_sublattice(grid, times[k], domains, tau, seed, i, k);
+			} else
+				run(times[k]);
+
+			options.write(out[k], k, i, grid.histogram());
+
+			if(i == 0 && picture) {
+				stat_scope timer(stat_picture);
+				grid.save_picture(pictures[k].c_str(), format);
+			}
+		}
+	}, streams);
+
+	options.finish(streams);
+
+	if(!walks.empty()) {
+		ofstream file(walks_file.c_str());
+		for(size_t r = 0; r < walks.size(); ++r) {
+			walks[r].for_each([&](uint32_t count, uint64_t events) {
+				file << r << " " << count << " " << events << "\n";
+			});
+		}
+	}
+
+	return 0;
+}
+
+// simulate_lattice for the given layout, specialised to the grid size if
+// it is a power of two
+template<typename Rule, typename Layout>
+int simulate_layout(const cmdline & args, image_format format, clone_format clones)
+{
+	return with_lattice_size(atoi(args[1]), [&](auto size) {
+		return simulate_lattice<Rule, Layout, decltype(size)>(args, format, clones);
+	});
+}
+
+// main for a model on a label_lattice: checks the command line and picks
+// the instantiation for the chosen layout and grid size
+template<typename Rule>
+int lattice_main(int argc, char ** argv)
+{
+	using namespace std;
+	typedef label_lattice<Rule, row_major_layout> lattice;
+
+	cmdline args(argc, argv);
+	image_format format;
+	clone_format clones;
+	const string layout = args.option("layout", "row");
+	if(args.size() <= 3 || !parse_image_format(args.option("format", ""), args.size() > 4 ? args[4] : "", format)
+			|| !parse_clone_format(args.option("clones", "text"), clones)
+			|| !known_layout(layout)) {
+		cout << "usage: " << args[0] << " <grid size> <time> <runs> [picture]"
+			<< model_options::usage() << " [--format=p3|p6|png] [--layout=row|morton|hilbert]"
+			<< (lattice::row_granularity > 0 ? " [--domains=n [--tau=t]]" : "")
+			<< (has_checkpoint<Rule>::value
+				? " [--checkpoint=file [--checkpoint-every=seconds]] [--resume=file]" : "")
+			<< " [--times=t1,t2,... [--times-prefix=prefix]]"
+			<< (has_dual<Rule, lattice>::value ? " [--dual]" : "")
+			<< (counts_events<lattice> ? " [--walks=file]" : "") << endl;
+		return -1;
+	}
+	if(atoi(args[1]) < 1 || size_t(atoi(args[1])) > max_lattice_side) {
+		cerr << "grid size must be from 1 to " << max_lattice_side << endl;
+		return -1;
+	}
+
+	if(layout == morton_layout::name())
+		return simulate_layout<Rule, morton_layout>(args, format, clones);
+	else if(layout == hilbert_layout::name())
+		return simulate_layout<Rule, hilbert_layout>(args, format, clones);
+	else
+		return simulate_layout<Rule, row_major_layout>(args, format, clones);
+}
+
+#endif // LATTICE_RUN_HPP
@@ -0,0 +1,139 @@
+#ifndef LAYOUT_HPP
+#define LAYOUT_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <boost/assert.hpp>
+#include "hilbert.hpp"
+
+// Where cell (i,j) of an N x N lattice lives in memory.
+//
+// Row major puts vertical neighbours N cells apart, so on big lattices every
+// event touches several cache lines and pages. The curve layouts cut the
+// lattice into 8x8 tiles, row major inside a tile, and order the tiles along
+// a space-filling curve: most neighbours are then in the same tile, and
+// neighbouring tiles are usually close in memory too.
+
+struct row_major_layout {
+	static const char * name() {return "row";}
+	explicit row_major_layout(int N_): N(N_) {}
+	size_t size() const {return size_t(N)*N;}
+	size_t operator()(int i, int j) const {return size_t(i)*N + j;}
+private:
+	int N;
+};
+
+// Tiles in Morton (Z) order. The tile index is computed by interleaving bits,
+// so needs no table, but the tiles fill a power of two square; storage is
+// padded to that.
+struct morton_layout {
+	static const char * name() {return "morton";}
+	explicit morton_layout(int N) {
+		uint32_t tiles = (N + 7) / 8, side = 1;
+		while(side < tiles) side <<= 1;
+		cells = size_t(side)*side*64;
+	}
+	size_t size() const {return cells;}
+	size_t operator()(int i, int j) const {
+		return (spread(i >> 3) << 1 | spread(j >> 3)) << 6 | (i & 7) << 3 | (j & 7);
+	}
+private:
+	size_t cells;
+	// put the bits of x in the even bit positions
+	static uint64_t spread(uint32_t x) {
+		uint64_t y = x;
+		y = (y | y << 16) & 0x0000ffff0000ffffULL;
+		y = (y | y << 8)  & 0x00ff00ff00ff00ffULL;
+		y = (y | y << 4)  & 0x0f0f0f0f0f0f0f0fULL;
+		y = (y | y << 2)  & 0x3333333333333333ULL;
+		y = (y | y << 1)  & 0x5555555555555555ULL;
+		return y;
+	}
+};
+
+// Tiles in hilbert order, which keeps consecutive tiles adjacent on the
+// lattice. The position of every tile along the curve is tabulated once per
+// grid size with hilbert_fill_2d and renumbered densely, so there is no
+// padding beyond whole tiles.
+struct hilbert_layout {
+	static const char * name() {return "hilbert";}
+	explicit hilbert_layout(int N): T((N + 7) / 8), tile(tile_order(T)) {}
+	size_t size() const {return size_t(T)*T*64;}
+	size_t operator()(int i, int j) const {
+		return size_t(tile[(i >> 3)*T + (j >> 3)]) << 6 | (i & 7) << 3 | (j & 7);
+	}
+private:
+	int T; // tiles per side
+	const uint32_t * tile;
+
+	static const uint32_t * tile_order(int T) {
+		static std::mutex cache_mutex;
+		static std::map<int, std::vector<uint32_t> > cache;
+		std::lock_guard<std::mutex> lock(cache_mutex);
+		std::vector<uint32_t> & order = cache[T];
+		if(order.empty()) {
+			std::vector<uint32_t> h(T*T);
+			BOOST_VERIFY(hilbert_fill_2d(ceil(log(T) / log(2)), T, T, &h[0]));
+			std::vector<uint32_t> by_h(h);
+			std::sort(by_h.begin(), by_h.end());
+			order.resize(T*T);
+			for(int k = 0; k < T*T; ++k)
+				order[k] = std::lower_bound(by_h.begin(), by_h.end(), h[k]) - by_h.begin();
+		}
+		return &order[0];
+	}
+};
+
+// An N x N lattice of T stored in the given layout.
+template<typename T, typename Layout>
+class lattice_storage {
+public:
+	explicit lattice_storage(int N): layout(N), owned(layout.size(), T()),
+		cells(&owned[0]), n(owned.size()) {}
+
+	// cells that live elsewhere, e.g. in a mapped checkpoint, which keep
+	// holds on to for as long as the lattice needs them
+	lattice_storage(int N, T * cells_, std::shared_ptr<void> keep_): layout(N),
+		cells(cells_), n(layout.size()), keep(keep_) {}
+
+	// copies always own their cells
+	lattice_storage(const lattice_storage & o): layout(o.layout),
+		owned(o.cells, o.cells + o.n), cells(&owned[0]), n(o.n) {}
+	lattice_storage & operator=(const lattice_storage & o) {
+		layout = o.layout;
+		owned.assign(o.cells, o.cells + o.n);
+		cells = &owned[0];
+		n = o.n;
+		keep.reset();
+		return *this;
+	}
+
+	T & operator()(int i, int j) {return cells[layout(i,j)];}
+	const T & operator()(int i, int j) const {return cells[layout(i,j)];}
+
+	// the raw cells, in layout order, including any padding
+	T * data() {return cells;}
+	const T * data() const {return cells;}
+	size_t size() const {return n;}
+
+private:
+	Layout layout;
+	std::vector<T> owned;
+	T * cells;
+	size_t n;
+	std::shared_ptr<void> keep;
+};
+
+inline bool known_layout(const std::string & name)
+{
+	return name == row_major_layout::name() || name == morton_layout::name()
+		|| name == hilbert_layout::name();
+}
+
+#endif // LAYOUT_HPP
@@ -0,0 +1,155 @@
+#ifndef MC_2D_AB_STRATIFY_HPP
+#define MC_2D_AB_STRATIFY_HPP
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <boost/assert.hpp>
+#include "lattice_model.hpp"
+#include "rng.hpp"
+#include "stats.hpp"
+
+// Cells are A (progenitors, 36% of them, scattered at random) or B. A B
+// stratifies at rate 1; the vacancy it leaves walks through B's, each moving
+// along behind it, until it reaches an A, which divides into it.
+struct ab_rule {
+	// the lowest bit is used to indicate A(1) or B(0); the upper 31 are a
+	// label, and 0 is an unlabelled B
+	typedef uint32_t cell_t;
+
+	uint32_t nB;
+	// every B site (as i*N + j) in no particular order, with each site's place
+	// in that list in B_position; kept up to date by make_A and make_B
+	std::vector<uint32_t> B_sites;
+	std::vector<uint32_t> B_position;
+
+	static const char * name() {return "mc_2d_AB_stratify";}
+	static bool labelled(cell_t c) {return c != 0;}
+	static uint32_t label(cell_t c) {return c >> 1;}
+
+	template<typename Lattice>
+	void initialise(Lattice & l, fast_rng & rng) {
+		const size_t N = l.N;
+		nB = N*N;
+		B_position.resize(N*N);
+		for(int i = 0; i < N; ++i) {
+			for(int j = 0; j < N; ++j) {
+				if(rng.uniform() < 0.36) { // A
+					l(i,j) = 0x1;
+					nB--;
+				} else { // B
+					l(i,j) = 0;
+					B_position[i*N + j] = B_sites.size();
+					B_sites.push_back(i*N + j);
+				}
+			}
+		}
+		relabel(l);
+	}
+
+	// every A gets a label of its own, and every B none
+	template<typename Lattice>
+	void relabel(Lattice & l) {
+		uint32_t label = 1;
+		for(int i = 0; i < l.N; ++i) {
+			for(int j = 0; j < l.N; ++j) {
+				if(l(i,j) & 0x1) { // A
+					l(i,j) = (label << 1) | 0x1;
+					label++;
+				} else { // B
+					l(i,j) = 0;
+				}
+			}
+		}
+		l.recount();
+	}
+
+	// Settles in for a while before the clones are labelled: runs to time
+	// 10, then starts the clock again with a label for every A.
+	template<typename Lattice>
+	void prepare(Lattice & l, fast_rng & rng, const std::function<void(double)> & run) {
+		l.time += l.next_event(rng);
+		run(10.0);
+		l.time = 0;
+		relabel(l);
+	}
+
+	// Once the B's or the A's have all gone, nothing can stratify or divide
+	// and the lattice stays as it is.
+	template<typename Lattice>
+	double total_rate(const Lattice & l) const {
+		return nB > 0 && nB < l.N*l.N ? nB : 0;
+	}
+
+	// A vacancy may walk any distance, so there are no sublattice runs.
+	static const int reach = 0;
+	static const int row_granularity = 0;
+
+	// Stratifies a B picked from all of them (rows are ignored), and walks
+	// the vacancy it leaves through B's until it is next to an A, which then
+	// divides into it. Returns the number of B's that moved along.
+	template<bool track, typename Lattice>
+	uint32_t event(Lattice & l, int, int, fast_rng & rng) {
+		const size_t N = l.N;
+		BOOST_ASSERT(nB > 0 && nB < N*N);
+		BOOST_ASSERT(nB == B_sites.size());
+		uint32_t b = B_sites[rng.below(nB)];
+		int i = b / N, j = b % N;
+		int next_i, next_j;
+		uint32_t hops = 0;
+		while(true) {
+			int dir = rng.bits(2);
+			next_i = (dir & 0x1) ? i : i + dir - 1;
+			next_j = (dir & 0x1) ? j + (dir&(~0x1)) - 1 : j;
+			l.wrap(next_i, next_j);
+
+			if(l(next_i,next_j) & 0x1) // found an A
+				break;
+
+			// move B into vacancy
+			l.template write<track>(i, j, l(next_i,next_j));
+			i = next_i; j = next_j;
+			hops++;
+		}
+		stat_count(stat_vacancy_hops, hops);
+
+		// divide A; clearing the A bit of a labelled cell leaves the clone
+		// sizes as they are
+		double r = 0.20;
+		double c = rng.uniform();
+		if(c < r) { // AA
+			l.template write<track>(i, j, l(next_i,next_j));
+			make_A(N, i, j);
+		} else if(c < 0.5) { // AB
+			l.template write<track>(i, j, l(next_i,next_j) & (~0x1));
+		} else if(c < (1-r)) { // BA
+			l.template write<track>(i, j, l(next_i,next_j));
+			l(next_i,next_j) &= ~0x1;
+			make_A(N, i, j);
+			make_B(N, next_i, next_j);
+		} else { // BB
+			l(next_i,next_j) &= ~0x1;
+			l.template write<track>(i, j, l(next_i,next_j));
+			make_B(N, next_i, next_j);
+		}
+		return hops;
+	}
+
+private:
+	// record a change of type of the cell at (i,j) in the B index
+	void make_A(size_t N, int i, int j) {
+		uint32_t b = i*N + j, last = B_sites.back();
+		B_sites[B_position[b]] = last;
+		B_position[last] = B_position[b];
+		B_sites.pop_back();
+		nB--;
+	}
+	void make_B(size_t N, int i, int j) {
+		uint32_t b = i*N + j;
+		B_position[b] = B_sites.size();
+		B_sites.push_back(b);
+		nB++;
+	}
+};
+
+#endif // MC_2D_AB_STRATIFY_HPP
@@ -1,129 +1,105 @@
-#include <boost/random.hpp>
+#include <algorithm>
+#include <cmath>
+#include <memory>
 #include <numeric>
 #include <iostream>
-#include <map>
+#include <string>
+#include <vector>
+#include <unordered_map>
 #include <utility>
 #include <cstdlib>
-#include <boost/multi_array.hpp>
-
-extern "C" {
-#include <fcntl.h>
-#include <unistd.h>
-}
-
-boost::mt19937 rng;
-
-struct grid_lattice {
-	typedef char cell_t;
-
-	explicit grid_lattice(int N_): time(0.0), N(N_), g(boost::extents[N][N]) {
-		active[std::make_pair(N/2,N/2)] = 0;
-		set(N/2, N/2, 1);
+#include "cmdline.hpp"
+#include "replicas.hpp"
+#include "rng.hpp"
+#include "clone_sizes.hpp"
+#include "clone_output.hpp"
+#include "model_options.hpp"
+#include "mc_2d_voter.hpp"
+#include "stats.hpp"
+
+// One replica to the given time, restarting the clone whenever it dies out;
+// returns its size.
+template<typename Lattice>
+uint64_t grow_clone(int N, double until, fast_rng & rng)
+{
+	Lattice grid(N);
+	while(true) {
+		double dt = grid.next_event(rng);
+		grid.time += dt;
+		if(grid.time > until) break;
+		grid.flip(rng);
+		stat_count(stat_events);
+		if(grid.empty()) grid.restart();
 	}
+	return grid.size();
+}
 
-	cell_t cell(int i, int j) const {sanitise(i,j); return g[i][j];}
-	void set(int i, int j, cell_t o) {
-		// precondition: active.find(make_pair(i,j)) != active.end();
-		// also, if cell(i,j) then its neighbours are in active
-
-		// asymmetry in flipping
-		if(cell(i,j) == o) return;
-		else if(o) { // up
-			cell_(i,j) = o;
-			inc_neighbours(i+1,j);
-			inc_neighbours(i-1,j);
-			inc_neighbours(i,j+1);
-			inc_neighbours(i,j-1);
-		} else { // down
-			cell_(i,j) = o;
-			if(labelled_neighbours(i,j) == 0)
-				active.erase(std::make_pair(i,j));
-			dec_neighbours(i+1,j);
-			dec_neighbours(i-1,j);
-			dec_neighbours(i,j+1);
-			dec_neighbours(i,j-1);
+// Runs grid to time end, or until its clone dies out, i.e. no cell is
+// labelled; a clone that has filled the lattice just waits for end. Jumping straight to
+// end when the next event would come later is exact, since the waiting time
+// has no memory.
+template<typename Lattice>
+void advance(Lattice & grid, double end, fast_rng & rng)
+{
+	while(!grid.empty()) {
+		double dt = grid.next_event(rng);
+		if(grid.time + dt > end) {
+			grid.time = end;
+			return;
 		}
+		grid.time += dt;
+		grid.flip(rng);
+		stat_count(stat_events);
 	}
+}
 
-	int labelled_neighbours(int i, int j) const {
-		return cell(i+1,j) + cell(i-1,j) + cell(i,j+1) + cell(i,j-1);
+// The clones of a population of runs replicas conditioned on surviving to
+// until, by population cloning: all replicas advance together in windows of
+// the given length, and at the end of each one every clone that has died is
+// replaced by a copy of a survivor picked uniformly. Survivors all carry the
+// same weight, so the population at until samples the conditioned clone size
+// distribution (up to O(1/runs) correlations between copies), and the
+// fraction surviving each window multiplies up to an estimate of the
+// survival probability. No work is thrown away on a restart, and the cost
+// grows with the clones, not with 1/P(survival).
+//
+// Replica i draws from its own generator, and resampling from one of its
+// own, so results depend only on the seed. Returns the clone sizes in
+// replica order, or nothing if the whole population died in one window.
+template<typename Lattice>
+std::vector<uint64_t> grow_population(int N, double until, int runs, double every,
+		int threads, uint32_t seed, double & survival)
+{
+	std::vector<std::unique_ptr<Lattice> > pool(runs);
+	std::vector<fast_rng> rng(runs);
+	for(int i = 0; i < runs; ++i) {
+		seed_replica(rng[i], seed, i);
+		pool[i].reset(new Lattice(N));
 	}
-
-	int size() const {
-		int s = 0;
-		for(int i = 0; i < N; ++i) {
-			for(int j = 0; j < N; ++j)
-				s += g[i][j];
+	fast_rng resample;
+	seed_replica(resample, seed, runs, 1);
+
+	survival = 1;
+	for(double t = 0; t < until; t = std::min(t + every, until)) {
+		const double end = std::min(t + every, until);
+		run_parallel(runs, threads, [&](int i) {advance(*pool[i], end, rng[i]);});
+
+		std::vector<int> alive;
+		for(int i = 0; i < runs; ++i)
+			if(!pool[i]->empty()) alive.push_back(i);
+		if(alive.empty())
+			return std::vector<uint64_t>();
+		survival *= double(alive.size()) / runs;
+		for(int i = 0; i < runs; ++i) {
+			if(pool[i]->empty())
+				pool[i].reset(new Lattice(*pool[alive[resample.below(alive.size())]]));
 		}
-		return s;
 	}
 
-	bool empty() const {return active.empty();}
-
-	double next_event() const {
-		using namespace boost;
-		exponential_distribution<> time_distribution(active.size());
-		variate_generator<mt19937 &, exponential_distribution<> >
-			event(rng, time_distribution);
-		return event();
-	}
-
-	void flip() {
-		// precondition: !empty();
-		using namespace boost;
-		uniform_int<> active_cell(0, active.size()-1);
-		variate_generator<mt19937 &, uniform_int<> >
-			active_cell_chooser(rng, active_cell);
-		active_list_t::iterator c = active.begin();
-		std::advance(c, active_cell_chooser());
-
-		uniform_int<> four(1, 4);
-		variate_generator<mt19937 &, uniform_int<> > d4(rng, four);
-		set(c->first.first, c->first.second, 
-			(cell_t)(d4()) > c->second ? 0 : 1);
-	}
-
-	void restart() {
-		// precondition: empty();
-		time = 0.0;
-		active[std::make_pair(N/2,N/2)] = 0;
-		set(N/2, N/2, 1);
-	}
-
-	double time;
-	const int N; // grid size
-
-private:
-	boost::multi_array<cell_t, 2> g;
-	typedef std::map<std::pair<int,int>, cell_t> active_list_t;
-	active_list_t active;
-
-	void sanitise(int & i, int & j) const {i = (i+N)%N; j = (j+N)%N;} // positive dividend
-	cell_t & cell_(int i, int j) {sanitise(i,j); return g[i][j];}
-	void inc_neighbours(int i, int j) {
-		sanitise(i,j);
-		active_list_t::iterator c = active.find(std::make_pair(i,j));
-		if(c == active.end())
-			active.insert(std::make_pair(std::make_pair(i,j), 1));
-		else
-			c->second++;
-	}
-	void dec_neighbours(int i, int j) {
-		sanitise(i,j);
-		active_list_t::iterator c = active.find(std::make_pair(i,j));
-		if(--(c->second) == 0 && cell(i,j) == 0)
-			active.erase(c);
-	}
-};
-
-std::ostream & operator<<(std::ostream & os, const grid_lattice & g)
-{
-	for(int i = 0; i < g.N; ++i) {
-		for(int j = 0; j < g.N; ++j)
-			os << static_cast<int>(g.cell(i,j)) << " ";
-		os << std::endl;
-	}
-	return os;
+	std::vector<uint64_t> sizes(runs);
+	for(int i = 0; i < runs; ++i)
+		sizes[i] = pool[i]->size();
+	return sizes;
 }
 
 int main(int argc, char ** argv)
@@ -131,35 +107,68 @@ int main(int argc, char ** argv)
 	using namespace std;
 	using namespace boost;
 
-	if(argc <= 3) {
-		cout << "usage: " << argv[0] << " <grid size> <time> <runs>" << endl;
+	cmdline args(argc, argv);
+	clone_format clones;
+	if(args.size() <= 3 || !parse_clone_format(args.option("clones", "text"), clones)) {
+		cout << "usage: " << args[0] << " <grid size> <time> <runs>" << model_options::usage()
+			<< " [--nfold] [--cloning [--cloning-every=t]]" << endl;
 		return -1;
 	}
 
-	int system_random = open("/dev/random", O_RDONLY);
-	uint32_t seed;
-	read(system_random, &seed, 4);
-	close(system_random);
-
-	rng.seed(seed);
-
-	for(int count = 0; count < atoi(argv[3]);) {
-		grid_lattice grid(atoi(argv[1]));
-		while(true) {
-			double dt = grid.next_event();
-			grid.time += dt;
-			if(grid.time > atof(argv[2])) break;
-			grid.flip();
-			if(grid.empty()) grid.restart();
-		}
+	// a --cloning-every that is not a positive number, or too small to move
+	// the clock on from <time>, would leave grow_population in one window
+	const string every_option = args.option("cloning-every", "1");
+	char * every_end;
+	const double every = strtod(every_option.c_str(), &every_end);
+	if(args.has("cloning") && (every_option.empty() || *every_end != '\0'
+			|| !(every > 0) || !std::isfinite(every) || atof(args[2]) + every == atof(args[2]))) {
+		cerr << "cannot use --cloning-every=" << every_option << ": it must be a positive time" << endl;
+		return -1;
+	}
 
-		if(!grid.empty()) {
-			cout << grid.size() << endl;
-//			cout << grid << endl;
-			count++;
+	model_options options(args, "mc_2d_voter", clones, run_seed(args));
+	const uint32_t seed = options.seed;
+
+	// with --nfold, events are drawn by the n-fold way of nfold_lattice, which
+	// never wastes one on a flip that changes nothing
+	const bool nfold = args.has("nfold");
+
+	// with --cloning, the replicas are one population conditioned on survival
+	// by grow_population, resampled every --cloning-every (default 1); its
+	// estimate of the survival probability goes to standard error
+	const bool cloning = args.has("cloning");
+	std::vector<uint64_t> population;
+	if(cloning) {
+		double survival;
+		population = nfold
+			? grow_population<nfold_lattice>(atoi(args[1]), atof(args[2]), atoi(args[3]), every, options.threads, seed, survival)
+			: grow_population<grid_lattice>(atoi(args[1]), atof(args[2]), atoi(args[3]), every, options.threads, seed, survival);
+		if(population.empty()) {
+			cerr << "all " << args[3] << " clones died out within one window;"
+				" use more runs or a shorter --cloning-every" << endl;
+			return -1;
 		}
+		cerr << "survival probability to " << args[2] << ": " << survival << endl;
 	}
 
+	options.writer.header(std::cout, atof(args[2]));
+
+	// restart() and cloning keep the clone alive, so every replica reports
+	// a survivor
+	run_replicas(atoi(args[3]), cloning ? 1 : options.threads, [&](int i, std::ostream & out) {
+		uint64_t size;
+		if(cloning)
+			size = population[i];
+		else {
+			fast_rng rng;
+			seed_replica(rng, seed, i);
+			size = nfold ? grow_clone<nfold_lattice>(atoi(args[1]), atof(args[2]), rng)
+				: grow_clone<grid_lattice>(atoi(args[1]), atof(args[2]), rng);
+		}
+		options.write(out, 0, i, size);
+	}, std::cout);
+
+	options.finish(std::vector<std::ostream *>(1, &std::cout));
+
 	return 0;
 }
- 
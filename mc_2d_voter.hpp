@@ -0,0 +1,276 @@
+#ifndef MC_2D_VOTER_HPP
+#define MC_2D_VOTER_HPP
+
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+#include "rng.hpp"
+#include "stats.hpp"
+
+// The cells of an N x N periodic lattice, labelled (1) or not (0), one bit
+// each, with a count of the labelled ones. The lattices below add the
+// dynamics.
+class voter_bits {
+public:
+	typedef char cell_t;
+	typedef uint64_t site_t; // i*N + j
+
+	explicit voter_bits(int N_): N(N_), W((N+63)/64), g(size_t(W)*N, 0), labelled(0) {}
+
+	cell_t cell(int i, int j) const {sanitise(i,j); return (word(i, j>>6) >> (j&63)) & 0x1;}
+
+	int labelled_neighbours(int i, int j) const {
+		sanitise(i,j);
+		int w = j>>6, b = j&63;
+		int up = i == 0 ? N-1 : i-1, down = i == N-1 ? 0 : i+1;
+		int n = ((word(up, w) >> b) & 0x1) + ((word(down, w) >> b) & 0x1);
+		if(b > 0 && b < 63 && j < N-1) // both sideways neighbours in this word
+			return n + __builtin_popcountll((word(i, w) >> (b-1)) & 0x5);
+		else
+			return n + cell(i,j-1) + cell(i,j+1);
+	}
+
+	uint64_t size() const {return labelled;}
+
+	const int N; // grid size
+
+protected:
+	void toggle(int i, int j) {
+		sanitise(i,j);
+		uint64_t & w = word(i, j>>6);
+		w ^= uint64_t(1) << (j&63);
+		labelled += (w >> (j&63)) & 0x1 ? 1 : -1;
+	}
+
+	// precondition: -N <= i,j < 2N; compares rather than divides
+	void sanitise(int & i, int & j) const {
+		i = i < 0 ? i + N : i >= N ? i - N : i;
+		j = j < 0 ? j + N : j >= N ? j - N : j;
+	}
+	site_t site(int i, int j) const {sanitise(i,j); return site_t(i)*N + j;}
+
+private:
+	// One bit per cell, 64 to a word. Word w of every row is stored together,
+	// so the words above and below a cell's word are its neighbours in memory.
+	const int W; // words per row
+	std::vector<uint64_t> g;
+	uint64_t labelled; // set bits in g, kept up to date by toggle
+
+	uint64_t word(int i, int w) const {return g[size_t(w)*N + i];}
+	uint64_t & word(int i, int w) {return g[size_t(w)*N + i];}
+};
+
+// A single clone growing from the centre of an N x N lattice under voter
+// dynamics, with only the sites that can change kept active.
+struct grid_lattice: public voter_bits {
+	explicit grid_lattice(int N_): voter_bits(N_), time(0.0) {
+		activate(site(N/2, N/2));
+		set(N/2, N/2, 1);
+	}
+
+	void set(int i, int j, cell_t o) {
+		// precondition: position.count(site(i,j));
+		// also, if cell(i,j) then its neighbours are in active
+
+		// asymmetry in flipping
+		if(cell(i,j) == o) {
+			stat_count(stat_noop_flips);
+			return;
+		}
+		toggle(i,j);
+		if(o) { // up
+			ensure_active(i+1,j);
+			ensure_active(i-1,j);
+			ensure_active(i,j+1);
+			ensure_active(i,j-1);
+		} else { // down
+			if(labelled_neighbours(i,j) == 0)
+				deactivate(site(i,j));
+			check_active(i+1,j);
+			check_active(i-1,j);
+			check_active(i,j+1);
+			check_active(i,j-1);
+		}
+	}
+
+	bool empty() const {return active.empty();}
+
+	double next_event(fast_rng & rng) const {
+		return rng.exponential(active.size());
+	}
+
+	void flip(fast_rng & rng) {
+		// precondition: !empty();
+		site_t c = active[rng.below(active.size())];
+		int i = c / N, j = c % N;
+
+		// 1 + bits(2) is uniform on 1..4
+		set(i, j, (cell_t)(1 + rng.bits(2)) > labelled_neighbours(i,j) ? 0 : 1);
+	}
+
+	void restart() {
+		// precondition: empty();
+		time = 0.0;
+		activate(site(N/2, N/2));
+		set(N/2, N/2, 1);
+	}
+
+	double time;
+
+private:
+	// Active sites are those labelled or with a labelled neighbour. They are
+	// kept in a dense list, with each one's place in that list in position,
+	// so that choosing, adding and removing one are all O(1). Only active
+	// sites have an entry, so memory follows the clone, not the lattice.
+	std::unordered_map<site_t, uint32_t> position;
+	std::vector<site_t> active;
+
+	void activate(site_t s) {
+		position[s] = active.size();
+		active.push_back(s);
+	}
+	// a no-op if s is not active: on a lattice of side 2 the sites above and
+	// below are one and the same, and so are those to either side, so
+	// check_active may come to a site twice
+	void deactivate(site_t s) {
+		std::unordered_map<site_t, uint32_t>::iterator p = position.find(s);
+		if(p == position.end()) return;
+		site_t last = active.back();
+		active[p->second] = last;
+		position[last] = p->second;
+		active.pop_back();
+		position.erase(p);
+	}
+	void ensure_active(int i, int j) {
+		site_t s = site(i,j);
+		if(position.find(s) == position.end())
+			activate(s);
+	}
+	void check_active(int i, int j) {
+		if(cell(i,j) == 0 && labelled_neighbours(i,j) == 0)
+			deactivate(site(i,j));
+	}
+};
+
+// The same dynamics with no null events: the n-fold way of Bortz, Kalos and
+// Lebowitz (J. Comput. Phys. 17, 10). In grid_lattice an active site with n
+// labelled neighbours becomes labelled with probability n/4, so a labelled
+// site actually flips at rate (4-n)/4 and an unlabelled one at rate n/4.
+// Sites are kept in classes by cell and n, all of a class flipping at the
+// same rate; each event picks a class by its share of the total rate and a
+// site uniformly within it, and always flips it. Time advances by the total
+// rate of actual flips.
+struct nfold_lattice: public voter_bits {
+	explicit nfold_lattice(int N_): voter_bits(N_), time(0.0), total(0) {
+		restart();
+	}
+
+	// The clone is gone only when no cell is labelled. A clone that has
+	// taken over the whole lattice has total rate 0 as well, and then the
+	// next event never comes.
+	bool empty() const {return size() == 0;}
+
+	double next_event(fast_rng & rng) const {
+		if(total == 0) return std::numeric_limits<double>::infinity();
+		return rng.exponential(total / 4.0);
+	}
+
+	void flip(fast_rng & rng) {
+		// precondition: total > 0, i.e. next_event was finite
+		// u picks a site in proportion to its rate, first among the classes
+		// and then, as the rest of u, within one
+		uint32_t u = rng.below(total), k = 0;
+		while(u >= rate(k) * members[k].size()) {
+			u -= rate(k) * members[k].size();
+			k++;
+		}
+		site_t c = members[k][u / rate(k)];
+		change(c / N, c % N);
+	}
+
+	void restart() {
+		// precondition: empty();
+		time = 0.0;
+		change(N/2, N/2);
+	}
+
+	double time;
+
+private:
+	// class k = cell*5 + labelled neighbours; sites of classes with rate 0
+	// (unlabelled with no labelled neighbours, or labelled with four) are
+	// left out
+	static const int classes = 10;
+	// four times the flip rate of a site of class k
+	static uint32_t rate(uint32_t k) {return k < 5 ? k : 9 - k;}
+	int site_class(int i, int j) const {return cell(i,j)*5 + labelled_neighbours(i,j);}
+
+	std::vector<site_t> members[classes];
+	// each site's place in its class, for the sites of nonzero rate; so as
+	// in grid_lattice, memory follows the clone
+	std::unordered_map<site_t, uint32_t> position;
+	uint32_t total; // four times the total rate
+
+	// Flips (i,j), moving it and its neighbours to their new classes: its own
+	// cell changes, and so does the labelled-neighbour count of the others,
+	// by one either way. On lattices of side 1 or 2 a site can be a neighbour
+	// more than once, or the cell itself; there each distinct site is moved
+	// once, by the sum of its changes.
+	void change(int i, int j) {
+		const int ni[5] = {i, i+1, i-1, i, i}, nj[5] = {j, j, j, j+1, j-1};
+		const int d = cell(i,j) ? -1 : 1;
+		for(int m = 0; m < 5; ++m) {
+			const site_t s = site(ni[m], nj[m]);
+			int delta = m == 0 ? 5*d : d;
+			if(N < 3) {
+				bool seen = false;
+				for(int n = 0; n < 5; ++n) {
+					if(n == m || site(ni[n], nj[n]) != s) continue;
+					seen |= n < m;
+					delta += d;
+				}
+				if(seen) continue;
+			}
+			const int k = site_class(ni[m], nj[m]);
+			reclass(s, k, k + delta);
+		}
+		toggle(i,j);
+	}
+	// with one lookup of s where it already has a place
+	void reclass(site_t s, int from, int to) {
+		if(rate(from) == 0) {
+			if(rate(to) == 0) return;
+			position[s] = members[to].size();
+			members[to].push_back(s);
+			total += rate(to);
+			return;
+		}
+		std::unordered_map<site_t, uint32_t>::iterator p = position.find(s);
+		site_t last = members[from].back();
+		members[from][p->second] = last;
+		position[last] = p->second;
+		members[from].pop_back();
+		total -= rate(from);
+		if(rate(to) == 0)
+			position.erase(p);
+		else {
+			p->second = members[to].size();
+			members[to].push_back(s);
+			total += rate(to);
+		}
+	}
+};
+
+inline std::ostream & operator<<(std::ostream & os, const voter_bits & g)
+{
+	for(int i = 0; i < g.N; ++i) {
+		for(int j = 0; j < g.N; ++j)
+			os << static_cast<int>(g.cell(i,j)) << " ";
+		os << std::endl;
+	}
+	return os;
+}
+
+#endif // MC_2D_VOTER_HPP
@@ -0,0 +1,224 @@
+/* microbenchmarks of the pieces every run spends its time in, as JSON */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <boost/version.hpp>
+#include "cmdline.hpp"
+#include "clone_output.hpp"
+#include "gut_model_A.hpp"
+#include "hilbert.hpp"
+#include "lattice_model.hpp"
+#include "layout.hpp"
+#include "mc_2d_AB_stratify.hpp"
+#include "mc_2d_voter.hpp"
+#include "pure_voter.hpp"
+#include "rng.hpp"
+
+// Results as a JSON array of {"name", "N", "ops", "ns_per_op"} objects.
+class report {
+public:
+	explicit report(std::ostream & os_): os(os_), first(true) {}
+
+	void add(const std::string & name, uint64_t N, uint64_t ops, double seconds) {
+		os << (first ? "\n" : ",\n") << "    {\"name\": \"" << name << "\", \"N\": " << N
+			<< ", \"ops\": " << ops << ", \"ns_per_op\": " << seconds * 1e9 / ops << "}";
+		first = false;
+		std::cerr << name << " N=" << N << ": " << seconds * 1e9 / ops << " ns" << std::endl;
+	}
+
+private:
+	std::ostream & os;
+	bool first;
+};
+
+// Calls op(batch) until at least min_seconds have gone by; adds the number of
+// operations done and the time taken to the report.
+double min_seconds = 0.25;
+
+template<typename Op>
+void measure(report & r, const std::string & name, uint64_t N, uint64_t batch, Op op)
+{
+	typedef std::chrono::steady_clock clock;
+	uint64_t ops = 0;
+	clock::time_point start = clock::now();
+	double seconds;
+	do {
+		op(batch);
+		ops += batch;
+		seconds = std::chrono::duration<double>(clock::now() - start).count();
+	} while(seconds < min_seconds);
+	r.add(name, N, ops, seconds);
+}
+
+// results that must not be optimised away end up here
+volatile uint64_t sink;
+
+void hilbert_benchmarks(report & r)
+{
+	const uint32_t order = 13, N = 1 << order;
+	fast_rng rng;
+
+	measure(r, "hilbert_index", N, 1 << 16, [&](uint64_t n) {
+		std::vector<uint32_t> p(2);
+		uint64_t s = 0;
+		for(uint64_t k = 0; k < n; ++k) {
+			p[0] = rng.below(N); p[1] = rng.below(N);
+			s += hilbert_index(2, order, p);
+		}
+		sink = s;
+	});
+	measure(r, "hilbert_point", N, 1 << 16, [&](uint64_t n) {
+		uint64_t s = 0;
+		for(uint64_t k = 0; k < n; ++k)
+			s += hilbert_point(2, order, rng.below(N) * uint64_t(N) + rng.below(N))[0];
+		sink = s;
+	});
+	measure(r, "hilbert_index_2d", N, 1 << 20, [&](uint64_t n) {
+		uint64_t s = 0;
+		for(uint64_t k = 0; k < n; ++k)
+			s += hilbert_index_2d(order, rng.below(N), rng.below(N));
+		sink = s;
+	});
+	measure(r, "hilbert_2_32_index", uint64_t(1) << 32, 1 << 20, [&](uint64_t n) {
+		uint64_t s = 0;
+		for(uint64_t k = 0; k < n; ++k)
+			s += hilbert<2, 32>::index({{uint32_t(rng()), uint32_t(rng())}});
+		sink = s;
+	});
+	measure(r, "hilbert_3_21_point", 1 << 21, 1 << 20, [&](uint64_t n) {
+		uint64_t s = 0;
+		for(uint64_t k = 0; k < n; ++k)
+			s += hilbert<3, 21>::point(rng() >> 1)[0];
+		sink = s;
+	});
+	measure(r, "hilbert_point_3d", 256, 1 << 20, [&](uint64_t n) {
+		uint64_t s = 0;
+		for(uint64_t k = 0; k < n; ++k)
+			s += hilbert_point_3d(8, rng.below(1 << 24))[0];
+		sink = s;
+	});
+	std::vector<uint32_t> fill(size_t(N) * N / 16);
+	measure(r, "hilbert_fill_2d", N / 4, fill.size(), [&](uint64_t) {
+		hilbert_fill_2d(order - 2, N / 4, N / 4, &fill[0]);
+		sink = fill[fill.size() / 2];
+	});
+}
+
+// events of a label_lattice model, including drawing the time to the next
+template<typename Rule>
+void event_benchmark(report & r, const std::string & name, int N)
+{
+	with_lattice_size(N, [&](auto size) {
+		fast_rng rng;
+		label_lattice<Rule, row_major_layout, decltype(size)> l(N, rng);
+		measure(r, name, N, 1 << 16, [&](uint64_t n) {
+			for(uint64_t k = 0; k < n; ++k) {
+				l.stratify_cell(rng);
+				l.time += l.next_event(rng);
+			}
+		});
+		return 0;
+	});
+}
+
+template<typename Lattice>
+void flip_benchmark(report & r, const std::string & name, int N)
+{
+	fast_rng rng;
+	Lattice l(N);
+	measure(r, name, N, 1 << 16, [&](uint64_t n) {
+		for(uint64_t k = 0; k < n; ++k) {
+			l.time += l.next_event(rng);
+			l.flip(rng);
+			if(l.empty()) l.restart();
+		}
+	});
+}
+
+void lattice_benchmarks(report & r, int N)
+{
+	event_benchmark<voter_rule>(r, "pure_voter_stratify_cell", N);
+	event_benchmark<gut_rule>(r, "gut_model_A_stratify_cell", N);
+
+	// a vacancy walk for every event, restarting if A's or B's die out
+	{
+		fast_rng rng;
+		typedef label_lattice<ab_rule, row_major_layout> ab_lattice;
+		std::unique_ptr<ab_lattice> l(new ab_lattice(N, rng));
+		measure(r, "mc_2d_AB_stratify_migrate_vacancy", N, 1 << 12, [&](uint64_t n) {
+			uint64_t hops = 0;
+			for(uint64_t k = 0; k < n; ++k) {
+				if(l->rule.nB == 0 || l->rule.nB == l->N*l->N)
+					l.reset(new ab_lattice(N, rng));
+				hops += l->stratify_cell(rng);
+				l->time += l->next_event(rng);
+			}
+			sink = hops;
+		});
+	}
+
+	// flips of a single clone, which is restarted when it dies out
+	flip_benchmark<grid_lattice>(r, "mc_2d_voter_flip", N);
+	flip_benchmark<nfold_lattice>(r, "mc_2d_voter_nfold_flip", N);
+
+	// clone sizes of a coarsened pure voter lattice: counting them from
+	// scratch, and writing them out in each format
+	fast_rng rng;
+	label_lattice<voter_rule, row_major_layout> l(N, rng);
+	while(l.time < 4) {
+		l.stratify_cell(rng);
+		l.time += l.next_event(rng);
+	}
+	measure(r, "histogram_recount", N, 1, [&](uint64_t) {l.recount();});
+	const clone_histogram & h = l.histogram();
+	for(clone_format format : {clones_text, clones_binary}) {
+		clone_writer writer(format, voter_rule::name(), N, 0, 1);
+		measure(r, format == clones_text ? "output_text" : "output_binary", N, 1, [&](uint64_t) {
+			std::ostringstream out;
+			writer.write(out, 0, h);
+			sink = out.str().size();
+		});
+	}
+}
+
+int main(int argc, char ** argv)
+{
+	using namespace std;
+
+	cmdline args(argc, argv);
+	if(args.size() > 1) {
+		cout << "usage: " << args[0] << " [--sizes=64,256,...] [--seconds=s] [--out=file]" << endl
+			<< "Times hilbert encoding and decoding, and per grid size the events,"
+			" clone counting and output of every model, and writes the results as JSON"
+			" (to standard output unless --out is given)." << endl;
+		return -1;
+	}
+	min_seconds = atof(args.option("seconds", "0.25").c_str());
+
+	vector<int> sizes;
+	istringstream list(args.option("sizes", "64,256,1024,4096,8192"));
+	string item;
+	while(getline(list, item, ','))
+		sizes.push_back(atoi(item.c_str()));
+
+	ofstream file;
+	if(args.has("out")) file.open(args.option("out", "").c_str());
+	ostream & os = args.has("out") ? file : cout;
+
+	os << "{\n  \"context\": {\"compiler\": \"" << __VERSION__ << "\", \"boost\": \""
+		<< BOOST_LIB_VERSION << "\", \"seconds\": " << min_seconds << "},\n  \"benchmarks\": [";
+	report r(os);
+	hilbert_benchmarks(r);
+	for(size_t k = 0; k < sizes.size(); ++k)
+		lattice_benchmarks(r, sizes[k]);
+	os << "\n  ]\n}" << endl;
+
+	return 0;
+}
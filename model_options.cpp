@@ -0,0 +1,53 @@
+#include "model_options.hpp"
+#include <cstdlib>
+#include "replicas.hpp"
+
+using namespace std;
+
+model_options::model_options(const cmdline & args, const char * model, clone_format clones,
+		uint32_t seed_, size_t observations):
+	seed(seed_), threads(run_threads(args)),
+	writer(clones, model, atoi(args[1]), seed_, atoi(args[3])),
+	distribution_only(args.has("distribution")), distribution(observations),
+	stats(args, model)
+{
+	buffer_standard_output();
+}
+
+const char * model_options::usage()
+{
+	return " [--threads=n] [--seed=s] [--distribution] [--clones=text|binary]"
+		" [--stats[=file] [--stats-every=seconds]]";
+}
+
+void model_options::write(ostream & out, size_t k, uint32_t replica, const clone_histogram & h)
+{
+	stat_scope timer(stat_clone_output);
+	if(distribution_only) {
+		lock_guard<mutex> lock(distribution_mutex);
+		distribution[k].add(h);
+	} else
+		writer.write(out, replica, h);
+}
+
+void model_options::write(ostream & out, size_t k, uint32_t replica, uint64_t size)
+{
+	stat_scope timer(stat_clone_output);
+	if(distribution_only) {
+		lock_guard<mutex> lock(distribution_mutex);
+		distribution[k].add(size);
+	} else if(writer.output_format() == clones_text)
+		out << size << "\n";
+	else {
+		size_distribution one;
+		one.add(size);
+		writer.write(out, replica, one);
+	}
+}
+
+void model_options::finish(const vector<ostream *> & os) const
+{
+	if(!distribution_only) return;
+	for(size_t k = 0; k < distribution.size(); ++k)
+		writer.write(*os[k], all_replicas, distribution[k]);
+}
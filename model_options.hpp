@@ -0,0 +1,54 @@
+#ifndef MODEL_OPTIONS_HPP
+#define MODEL_OPTIONS_HPP
+
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <vector>
+#include "clone_output.hpp"
+#include "clone_sizes.hpp"
+#include "cmdline.hpp"
+#include "stats.hpp"
+
+// The options every model takes, on a command line that starts
+// <grid size> <time> <runs>:
+//   --seed=s, --threads=n  as run_seed and run_threads read them
+//   --distribution         clone sizes are tallied across all replicas and
+//                          written once at the end as "size count" lines
+//   --clones=text|binary   clone sizes as text, or in the compact format of
+//                          clone_output.hpp
+//   --stats[=file] [--stats-every=seconds]
+//                          throughput and where the time goes, in builds
+//                          with COARSEN_STATS
+// A run may observe its replicas at several times, each with its own output.
+// Make one once the command line has been checked, before anything is
+// written to standard output.
+class model_options {
+public:
+	model_options(const cmdline & args, const char * model, clone_format clones,
+		uint32_t seed, size_t observations = 1);
+
+	// for the usage line
+	static const char * usage();
+
+	const uint32_t seed;
+	const int threads;
+	const clone_writer writer;
+
+	// The clones of a replica at observation k: written to out, or added to
+	// the tally with --distribution. A single size is a replica that is one
+	// clone, alone on a line as text.
+	void write(std::ostream & out, size_t k, uint32_t replica, const clone_histogram & h);
+	void write(std::ostream & out, size_t k, uint32_t replica, uint64_t size);
+
+	// with --distribution, the tally of observation k to os[k]
+	void finish(const std::vector<std::ostream *> & os) const;
+
+private:
+	const bool distribution_only;
+	std::mutex distribution_mutex;
+	std::vector<size_distribution> distribution;
+	stats_reporter stats;
+};
+
+#endif // MODEL_OPTIONS_HPP
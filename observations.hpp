@@ -0,0 +1,53 @@
+#ifndef OBSERVATIONS_HPP
+#define OBSERVATIONS_HPP
+
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Times at which one run is observed: those of a comma separated list that
+// fall in [from, until), in increasing order without repeats, then until
+// itself. Anything in the list that does not parse as a number is an error,
+// reported by returning an empty schedule.
+inline std::vector<double> observation_times(const std::string & list, double from, double until)
+{
+	std::vector<double> times;
+	std::istringstream in(list);
+	std::string item;
+	while(std::getline(in, item, ',')) {
+		char * end;
+		double t = strtod(item.c_str(), &end);
+		if(item.empty() || *end != '\0' || t < 0)
+			return std::vector<double>();
+		if(t >= from && t < until)
+			times.push_back(t);
+	}
+	std::sort(times.begin(), times.end());
+	times.erase(std::unique(times.begin(), times.end()), times.end());
+	times.push_back(until);
+	return times;
+}
+
+// Where the extension of filename starts: at its last dot, unless that is in
+// a directory name, or else at the end.
+inline size_t extension_start(const std::string & filename)
+{
+	size_t dot = filename.rfind('.');
+	if(dot == std::string::npos || filename.find('/', dot) != std::string::npos)
+		dot = filename.size();
+	return dot;
+}
+
+// The file for the observation at time t of a series of files named after
+// prefix: "pv" becomes "pv-16.txt" when given extension ".txt".
+inline std::string observation_name(const std::string & prefix, double t,
+		const std::string & extension)
+{
+	std::ostringstream name;
+	name << prefix << "-" << t << extension;
+	return name.str();
+}
+
+#endif // OBSERVATIONS_HPP
@@ -0,0 +1,44 @@
+#ifndef PALETTE_HPP
+#define PALETTE_HPP
+
+#include <cstdint>
+#include <vector>
+#include <boost/array.hpp>
+#include "hilbert.hpp"
+
+// Maps clone labels to picture colours. A label is hashed to a point on the
+// hilbert curve through the RGB cube, so that unrelated labels get unrelated
+// colours. Labels are dense, so colours are cached in a flat table and each
+// label is decoded only once, however many frames it appears in.
+class label_palette {
+public:
+	typedef boost::array<uint8_t, 3> rgb_t;
+
+	rgb_t operator()(uint32_t label) {
+		if(label >= cache.size())
+			cache.resize(label + 1, 0);
+		uint32_t & c = cache[label];
+		if(c == 0) {
+			hilbert<3, 8>::point_t p = hilbert<3, 8>::point(hash(label) >> 8);
+			c = known | p[0] << 16 | p[1] << 8 | p[2];
+		}
+		rgb_t rgb = {{uint8_t(c >> 16), uint8_t(c >> 8), uint8_t(c)}};
+		return rgb;
+	}
+
+private:
+	static const uint32_t known = 0x1000000;
+	// 0 for labels not yet seen, otherwise known | 0xRRGGBB
+	std::vector<uint32_t> cache;
+
+	static uint32_t hash(uint32_t x) {
+		x ^= x >> 16;
+		x *= 0x7feb352dU;
+		x ^= x >> 15;
+		x *= 0x846ca68bU;
+		x ^= x >> 16;
+		return x;
+	}
+};
+
+#endif // PALETTE_HPP
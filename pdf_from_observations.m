@@ -1,10 +1,19 @@
 function [mu, p] = pdf_from_observations(file)
 
-ms = load(file);
-total = numel(ms);
-average = sum(ms) / total;
-counts = histc(ms, 1:max(ms));
+% either one clone size per line, or "size count" lines from --distribution
+% this loads the whole file; for big runs, clone_stats --pdf <file> writes the
+% same mu p pairs in one pass
+data = load(file);
+if size(data, 2) == 2
+    ms = data(:,1); weights = data(:,2);
+else
+    ms = data; weights = ones(size(ms));
+end
+total = sum(weights);
+average = sum(ms .* weights) / total;
+keep = ms > 0;
+counts = accumarray(ms(keep), weights(keep), [max(ms) 1]);
 p = counts / total * average;
 mu = (1:max(ms)) / average;
 
-end
\ No newline at end of file
+end
@@ -0,0 +1,51 @@
+#ifndef PURE_VOTER_HPP
+#define PURE_VOTER_HPP
+
+#include <cstdint>
+#include "coalescing.hpp"
+#include "lattice_model.hpp"
+#include "rng.hpp"
+
+// Every cell is replaced at rate 1 by a copy of one of its four nearest
+// neighbours. Cells start with their own hilbert index as label.
+struct voter_rule: stateless_rule {
+	typedef uint32_t cell_t; // label
+
+	static const char * name() {return "pure_voter";}
+	static bool labelled(cell_t) {return true;}
+	static uint32_t label(cell_t c) {return c;}
+
+	template<typename Lattice>
+	void initialise(Lattice & l, fast_rng &) {
+		l.fill_hilbert([](uint32_t h, int, int) {return h;});
+	}
+
+	template<typename Lattice>
+	double total_rate(const Lattice & l) const {return l.N*l.N;}
+
+	// only the cell and one nearest neighbour are involved
+	static const int reach = 1;
+	static const int row_granularity = 1;
+	template<typename Lattice>
+	double rate(const Lattice & l, int begin, int end) const {return double(end - begin) * l.N;}
+
+	template<bool track, typename Lattice>
+	void event(Lattice & l, int begin, int end, fast_rng & rng)
+	{
+		// pick cell
+		int i = begin + rng.below(end - begin), j = rng.below(l.N);
+
+		// replace with neighbour
+		int ai = i, aj = j;
+		von_neumann_step(ai, aj, 1, rng);
+		l.wrap(ai, aj);
+		l.template write<track>(i, j, l(ai,aj));
+	}
+
+	// for --dual: the cells at time until straight from those at time 0, by
+	// coalescing random walks
+	template<typename Lattice>
+	void dual(Lattice & l, double until, fast_rng & rng) {coalesce_walks(l, until, rng);}
+};
+
+#endif // PURE_VOTER_HPP
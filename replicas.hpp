@@ -0,0 +1,120 @@
+#ifndef REPLICAS_HPP
+#define REPLICAS_HPP
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <boost/random/seed_seq.hpp>
+#include "cmdline.hpp"
+
+extern "C" {
+#include <fcntl.h>
+#include <unistd.h>
+}
+
+// --seed=s, or else four bytes of /dev/random
+inline uint32_t run_seed(const cmdline & args)
+{
+	uint32_t seed;
+	if(args.has("seed"))
+		seed = strtoul(args.option("seed", "").c_str(), 0, 0);
+	else {
+		int system_random = open("/dev/random", O_RDONLY);
+		read(system_random, &seed, 4);
+		close(system_random);
+	}
+	return seed;
+}
+
+// --threads=n, where 0 or less means one per core; 1 without the option
+inline int run_threads(const cmdline & args)
+{
+	int threads = args.has("threads") ? atoi(args.option("threads", "").c_str()) : 1;
+	if(threads <= 0) threads = std::thread::hardware_concurrency();
+	return threads;
+}
+
+// Every replica draws from its own generator, seeded from the run seed and its
+// index only, so a replica's output does not depend on which thread ran it or
+// on how many threads there were.
+template<typename Engine>
+void seed_replica(Engine & rng, uint32_t seed, uint32_t replica)
+{
+	boost::random::seed_seq s = {seed, replica};
+	rng.seed(s);
+}
+
+// for replicas that use more than one generator
+template<typename Engine>
+void seed_replica(Engine & rng, uint32_t seed, uint32_t replica, uint32_t stream)
+{
+	boost::random::seed_seq s = {seed, replica, stream};
+	rng.seed(s);
+}
+
+// Calls f(k) for k = 0 .. n-1 on the given number of threads, the calling
+// one among them, and returns when all are done. Idle threads take the next
+// k not yet started, so uneven calls still keep every thread busy.
+template<typename F>
+void run_parallel(int n, int threads, F f)
+{
+	std::atomic<int> next(0);
+	auto worker = [&]() {
+		for(int k = next++; k < n; k = next++)
+			f(k);
+	};
+
+	std::vector<std::thread> pool;
+	for(int t = 1; t < threads; ++t)
+		pool.push_back(std::thread(worker));
+	worker();
+	for(size_t t = 0; t < pool.size(); ++t)
+		pool[t].join();
+}
+
+// Runs run(replica, out) for replica = 0 .. runs-1 on the given number of
+// threads, where out holds one buffer for each of the streams in os. Buffers
+// are copied to their streams in replica order as soon as all earlier
+// replicas are done.
+template<typename Run>
+void run_replicas(int runs, int threads, Run run, const std::vector<std::ostream *> & os)
+{
+	std::mutex output;
+	std::map<int, std::vector<std::string> > finished;
+	int written = 0;
+
+	run_parallel(runs, threads, [&](int r) {
+		std::vector<std::ostringstream> out(os.size());
+		run(r, out);
+
+		std::lock_guard<std::mutex> lock(output);
+		std::vector<std::string> & done = finished[r];
+		for(size_t k = 0; k < os.size(); ++k)
+			done.push_back(out[k].str());
+		for(std::map<int, std::vector<std::string> >::iterator i = finished.begin();
+				i != finished.end() && i->first == written; i = finished.begin()) {
+			for(size_t k = 0; k < os.size(); ++k)
+				*os[k] << i->second[k];
+			finished.erase(i);
+			written++;
+		}
+	});
+}
+
+// the same with a single stream, run(replica, out) writing to one buffer
+template<typename Run>
+void run_replicas(int runs, int threads, Run run, std::ostream & os)
+{
+	run_replicas(runs, threads, [&](int r, std::vector<std::ostringstream> & out) {
+		run(r, out[0]);
+	}, std::vector<std::ostream *>(1, &os));
+}
+
+#endif // REPLICAS_HPP
@@ -0,0 +1,149 @@
+#ifndef RNG_HPP
+#define RNG_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Random numbers for the simulations, produced a block at a time.
+//
+// Raw words come from eight independent xoshiro256** generators stepped side
+// by side; the state is laid out lane by lane so the refill loop vectorises.
+// On top of that:
+//   below(n)       uniform integer in [0, n), by Lemire's multiply-shift
+//   bits(k)        k fair bits, sliced off a buffered word (coin() is bits(1))
+//   uniform()      uniform double in [0, 1)
+//   exponential(r) exponential variate of rate r, from a buffer of standard
+//                  exponentials computed a block at a time
+//
+// It is a UniformRandomBitGenerator, so the boost and std distributions still
+// work with it. The whole state is plain data and may be copied byte for byte.
+class fast_rng {
+public:
+	typedef uint64_t result_type;
+	static constexpr size_t lanes = 8;
+	static constexpr size_t block = 256;
+
+	static constexpr result_type min() {return 0;}
+	static constexpr result_type max() {return ~result_type(0);}
+
+	fast_rng() {seed(0);}
+
+	void seed(uint64_t s) {
+		// splitmix64 to spread one word over all the state
+		for(size_t w = 0; w < 4; ++w) {
+			for(size_t l = 0; l < lanes; ++l) {
+				s += 0x9e3779b97f4a7c15ULL;
+				uint64_t z = s;
+				z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+				z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+				state[w][l] = z ^ (z >> 31);
+			}
+		}
+		discard_buffers();
+	}
+
+	// as for the standard engines, e.g. from a boost::random::seed_seq
+	template<typename SeedSeq>
+	void seed(SeedSeq & q) {
+		uint32_t words[8*lanes];
+		q.generate(words, words + 8*lanes);
+		for(size_t w = 0; w < 4; ++w) {
+			for(size_t l = 0; l < lanes; ++l) {
+				size_t k = 2*(w*lanes + l);
+				state[w][l] = uint64_t(words[k]) << 32 | words[k+1];
+			}
+		}
+		// the all zero state is a fixed point of every lane
+		for(size_t l = 0; l < lanes; ++l) {
+			if((state[0][l] | state[1][l] | state[2][l] | state[3][l]) == 0)
+				state[0][l] = l + 1;
+		}
+		discard_buffers();
+	}
+
+	result_type operator()() {
+		if(next_word == block) {
+			generate(words);
+			next_word = 0;
+		}
+		return words[next_word++];
+	}
+
+	uint32_t below(uint32_t n) {
+		uint64_t m = ((*this)() >> 32) * n;
+		uint32_t l = uint32_t(m);
+		if(l < n) {
+			uint32_t t = -n % n;
+			while(l < t) {
+				m = ((*this)() >> 32) * n;
+				l = uint32_t(m);
+			}
+		}
+		return m >> 32;
+	}
+
+	uint32_t bits(uint32_t k) {
+		// precondition: 0 < k <= 32
+		if(bits_left < k) {
+			bit_word = (*this)();
+			bits_left = 64;
+		}
+		uint32_t b = bit_word & ((uint64_t(1) << k) - 1);
+		bit_word >>= k;
+		bits_left -= k;
+		return b;
+	}
+
+	bool coin() {return bits(1);}
+
+	double uniform() {return ((*this)() >> 11) * 0x1.0p-53;}
+
+	double exponential(double rate) {
+		if(next_exponential == block) {
+			uint64_t raw[block];
+			generate(raw);
+			for(size_t k = 0; k < block; ++k)
+				exponentials[k] = -std::log(((raw[k] >> 11) + 1) * 0x1.0p-53);
+			next_exponential = 0;
+		}
+		return exponentials[next_exponential++] / rate;
+	}
+
+private:
+	uint64_t state[4][lanes];
+	uint64_t words[block];
+	double exponentials[block];
+	uint64_t bit_word;
+	uint32_t next_word, next_exponential, bits_left;
+
+	void discard_buffers() {
+		next_word = block;
+		next_exponential = block;
+		bits_left = 0;
+	}
+
+	static uint64_t rotl(uint64_t x, int k) {return (x << k) | (x >> (64 - k));}
+
+	// xoshiro256**, one step of every lane per pass
+	void generate(uint64_t * out) {
+		for(size_t k = 0; k < block; k += lanes) {
+			for(size_t l = 0; l < lanes; ++l) {
+				out[k + l] = rotl(state[1][l] * 5, 7) * 9;
+				uint64_t t = state[1][l] << 17;
+				state[2][l] ^= state[0][l];
+				state[3][l] ^= state[1][l];
+				state[1][l] ^= state[2][l];
+				state[0][l] ^= state[3][l];
+				state[2][l] ^= t;
+				state[3][l] = rotl(state[3][l], 45);
+			}
+		}
+	}
+};
+
+// checkpoints save and restore generators byte for byte
+static_assert(std::is_trivially_copyable<fast_rng>::value, "fast_rng must be plain data");
+
+#endif // RNG_HPP
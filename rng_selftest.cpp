@@ -0,0 +1,176 @@
+/* Statistical checks of fast_rng: every draw it offers, and the independence
+ * of its eight lanes once seeded from a seed_seq as every replica is. Each
+ * check is reduced to a z score, roughly standard normal if the generator is
+ * good, and fails beyond five. Seeds are fixed, so a run always gives the
+ * same scores.
+*/
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "replicas.hpp"
+#include "rng.hpp"
+
+bool ok = true;
+
+void check(const std::string & what, double z)
+{
+	const bool passed = std::fabs(z) <= 5;
+	std::cout << "  " << what << ": z = " << z << (passed ? "" : "  FAILED") << std::endl;
+	ok &= passed;
+}
+
+// Wilson and Hilferty: the cube root of chi2/df is close to normal
+double chi2_z(double chi2, double df)
+{
+	return (std::cbrt(chi2 / df) - (1 - 2 / (9 * df))) / std::sqrt(2 / (9 * df));
+}
+
+// below(n) over its range, in at most 64 equal bins
+void check_below(fast_rng & rng, uint32_t n)
+{
+	const uint32_t bins = n < 64 ? n : 64;
+	const uint64_t samples = 100000;
+	std::vector<uint64_t> count(bins, 0);
+	for(uint64_t k = 0; k < samples; ++k) {
+		const uint32_t x = rng.below(n);
+		if(x >= n) {
+			check("below(" + std::to_string(n) + ") in range", 1e9);
+			return;
+		}
+		count[uint64_t(x) * bins / n]++;
+	}
+	double chi2 = 0;
+	for(uint32_t b = 0; b < bins; ++b) {
+		// bins of uneven width when bins does not divide n
+		const double expected = double(samples) *
+			((uint64_t(b + 1) * n + bins - 1) / bins - (uint64_t(b) * n + bins - 1) / bins) / n;
+		chi2 += (count[b] - expected) * (count[b] - expected) / expected;
+	}
+	check("below(" + std::to_string(n) + ") chi-square", chi2_z(chi2, bins - 1));
+}
+
+// each bit of draw() set half the time, and successive draws uncorrelated
+template<typename Draw>
+void check_bits(const std::string & what, uint32_t k, Draw draw)
+{
+	const uint64_t samples = 200000;
+	std::vector<uint64_t> ones(k, 0);
+	double previous = 0, sum = 0, sum2 = 0, lagged = 0;
+	for(uint64_t s = 0; s < samples; ++s) {
+		const uint32_t x = draw();
+		for(uint32_t b = 0; b < k; ++b)
+			ones[b] += (x >> b) & 1;
+		if(k < 32 && (x >> k) != 0) {
+			check(what + " in range", 1e9);
+			return;
+		}
+		sum += x;
+		sum2 += double(x) * x;
+		if(s > 0) lagged += previous * x;
+		previous = x;
+	}
+	double worst = 0;
+	for(uint32_t b = 0; b < k; ++b) {
+		const double z = (ones[b] - samples / 2.0) / std::sqrt(samples / 4.0);
+		if(std::fabs(z) > std::fabs(worst)) worst = z;
+	}
+	check(what + " bit balance" + (k > 1 ? " (worst of " + std::to_string(k) + " bits)" : ""), worst);
+
+	const double mean = sum / samples, variance = sum2 / samples - mean * mean;
+	const double r = (lagged / (samples - 1) - mean * mean) / variance;
+	check(what + " serial correlation", r * std::sqrt(double(samples)));
+}
+
+// mean and variance of draw() against those of the distribution; fourth is
+// the fourth central moment, which gives the spread of the sample variance
+template<typename Draw>
+void check_moments(const std::string & what, double mean, double variance, double fourth, Draw draw)
+{
+	const uint64_t samples = 1000000;
+	double sum = 0, squares = 0;
+	for(uint64_t s = 0; s < samples; ++s) {
+		const double x = draw();
+		sum += x;
+		squares += (x - mean) * (x - mean);
+	}
+	check(what + " mean", (sum / samples - mean) / std::sqrt(variance / samples));
+	check(what + " variance", (squares / samples - variance)
+		/ std::sqrt((fourth - variance * variance) / samples));
+}
+
+double correlation(const std::vector<double> & sum, const std::vector<double> & sum2,
+		const std::vector<std::vector<double> > & cross, size_t a, size_t b, uint64_t n)
+{
+	const double ma = sum[a] / n, mb = sum[b] / n;
+	return (cross[a][b] / n - ma * mb)
+		/ std::sqrt((sum2[a] / n - ma * ma) * (sum2[b] / n - mb * mb));
+}
+
+// Words come from the lanes in turn, so word k of a block is from lane
+// k % lanes. The top 32 bits of every pair of lanes must be uncorrelated, and
+// so must two replicas seeded alike but for the replica number.
+void check_lanes()
+{
+	const size_t lanes = fast_rng::lanes;
+	const uint64_t rounds = 100000;
+	fast_rng rng, other;
+	seed_replica(rng, 1, 0);
+	seed_replica(other, 1, 1);
+
+	std::vector<double> sum(lanes + 1, 0), sum2(lanes + 1, 0);
+	std::vector<std::vector<double> > cross(lanes + 1, std::vector<double>(lanes + 1, 0));
+	for(uint64_t k = 0; k < rounds; ++k) {
+		double x[lanes + 1];
+		for(size_t l = 0; l < lanes; ++l)
+			x[l] = (rng() >> 32) * 0x1.0p-32 - 0.5;
+		x[lanes] = (other() >> 32) * 0x1.0p-32 - 0.5;
+		for(size_t a = 0; a <= lanes; ++a) {
+			sum[a] += x[a];
+			sum2[a] += x[a] * x[a];
+			for(size_t b = a + 1; b <= lanes; ++b)
+				cross[a][b] += x[a] * x[b];
+		}
+	}
+
+	double worst = 0;
+	for(size_t a = 0; a < lanes; ++a) {
+		for(size_t b = a + 1; b < lanes; ++b) {
+			const double z = correlation(sum, sum2, cross, a, b, rounds) * std::sqrt(double(rounds));
+			if(std::fabs(z) > std::fabs(worst)) worst = z;
+		}
+	}
+	check("lane correlation after seed(seed_seq) (worst of "
+		+ std::to_string(lanes * (lanes - 1) / 2) + " pairs)", worst);
+	check("correlation of replicas 0 and 1, lane 0",
+		correlation(sum, sum2, cross, 0, lanes, rounds) * std::sqrt(double(rounds)));
+}
+
+int main()
+{
+	fast_rng rng;
+	seed_replica(rng, 12345, 0);
+
+	std::cout << "below(n)" << std::endl;
+	for(uint32_t n : {2u, 16u, 64u, 1u << 20, 1u << 31})
+		check_below(rng, n);
+	for(uint32_t n : {3u, 10u, 100u, 1000003u, 3u << 30})
+		check_below(rng, n);
+
+	std::cout << "bits(k) and coin()" << std::endl;
+	for(uint32_t k : {1u, 3u, 7u, 32u})
+		check_bits("bits(" + std::to_string(k) + ")", k, [&] {return rng.bits(k);});
+	check_bits("coin()", 1, [&] {return uint32_t(rng.coin());});
+
+	std::cout << "uniform() and exponential(r)" << std::endl;
+	check_moments("uniform()", 0.5, 1.0 / 12, 1.0 / 80, [&] {return rng.uniform();});
+	const double r = 2.5;
+	check_moments("exponential(2.5)", 1 / r, 1 / (r*r), 9 / (r*r*r*r), [&] {return rng.exponential(r);});
+
+	std::cout << "lanes" << std::endl;
+	check_lanes();
+
+	return ok ? 0 : 1;
+}
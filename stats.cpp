@@ -0,0 +1,153 @@
+#include "stats.hpp"
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+const char * counter_names[stat_counters] = {
+	"events", "noop_writes", "noop_flips", "vacancy_hops"
+};
+const char * timer_names[stat_timers] = {
+	"recount", "clone_output", "picture", "checkpoint"
+};
+
+// Every block ever handed out, so that the totals include threads that have
+// finished. A thread's block goes back on the free list when it ends, counts
+// and all, for the next thread to carry on from.
+struct stats_blocks {
+	std::mutex m;
+	std::vector<std::unique_ptr<thread_stats> > all;
+	std::vector<thread_stats *> free;
+
+	static stats_blocks & instance() {
+		static stats_blocks blocks;
+		return blocks;
+	}
+
+	thread_stats * take() {
+		std::lock_guard<std::mutex> lock(m);
+		if(free.empty()) {
+			all.emplace_back(new thread_stats);
+			return all.back().get();
+		}
+		thread_stats * s = free.back();
+		free.pop_back();
+		return s;
+	}
+
+	void give_back(thread_stats * s) {
+		std::lock_guard<std::mutex> lock(m);
+		free.push_back(s);
+	}
+
+	void sum(uint64_t * counts, uint64_t * cycles) {
+		std::lock_guard<std::mutex> lock(m);
+		for(int c = 0; c < stat_counters; ++c) counts[c] = 0;
+		for(int t = 0; t < stat_timers; ++t) cycles[t] = 0;
+		for(size_t k = 0; k < all.size(); ++k) {
+			for(int c = 0; c < stat_counters; ++c)
+				counts[c] += all[k]->counts[c].load(std::memory_order_relaxed);
+			for(int t = 0; t < stat_timers; ++t)
+				cycles[t] += all[k]->cycles[t].load(std::memory_order_relaxed);
+		}
+	}
+};
+
+// gives the thread's block back when the thread ends
+struct stats_owner {
+	~stats_owner() {
+		if(current_stats) stats_blocks::instance().give_back(current_stats);
+	}
+};
+
+}
+
+thread_stats & attach_stats()
+{
+	static thread_local stats_owner owner;
+	current_stats = stats_blocks::instance().take();
+	return *current_stats;
+}
+
+stats_reporter::stats_reporter(const cmdline & args, const char * model_): model(model_),
+		every(atof(args.option("stats-every", "5").c_str())), start(std::chrono::steady_clock::now()),
+		start_cycles(stat_cycles()), last_events(0), last_seconds(0), stopping(false)
+{
+	if(!args.has("stats"))
+		return;
+	if(!stats_enabled) {
+		std::cerr << "--stats needs a build with COARSEN_STATS (cmake -DSTATS=ON)" << std::endl;
+		return;
+	}
+	const std::string filename = args.option("stats", "");
+	if(!filename.empty()) {
+		file.reset(new std::ofstream(filename.c_str(), std::ios::app));
+		if(!*file) {
+			std::cerr << "cannot write " << filename << "; stats go to standard error" << std::endl;
+			file.reset();
+		}
+	}
+	if(every <= 0) every = 5;
+
+	thread = std::thread([this]() {
+		std::unique_lock<std::mutex> lock(m);
+		while(!stop_now.wait_for(lock, std::chrono::duration<double>(every), [this] {return stopping;}))
+			report(false);
+	});
+}
+
+stats_reporter::~stats_reporter()
+{
+	if(!thread.joinable())
+		return;
+	{
+		std::lock_guard<std::mutex> lock(m);
+		stopping = true;
+	}
+	stop_now.notify_all();
+	thread.join();
+	report(true);
+}
+
+// Totals so far, and events per second both over the whole run and since the
+// last report. Cycles become seconds at the rate the counter has run since
+// the reporter started.
+void stats_reporter::report(bool last)
+{
+	uint64_t counts[stat_counters], cycles[stat_timers];
+	stats_blocks::instance().sum(counts, cycles);
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	const double cycles_per_second = seconds > 0 ? (stat_cycles() - start_cycles) / seconds : 1;
+	const double rate = seconds > 0 ? counts[stat_events] / seconds : 0;
+	const double recent = seconds > last_seconds
+		? (counts[stat_events] - last_events) / (seconds - last_seconds) : 0;
+	last_events = counts[stat_events];
+	last_seconds = seconds;
+
+	std::ostringstream line;
+	if(file) {
+		line << "{\"model\": \"" << model << "\", \"final\": " << (last ? "true" : "false")
+			<< ", \"seconds\": " << seconds << ", \"events_per_second\": " << rate
+			<< ", \"recent_events_per_second\": " << recent;
+		for(int c = 0; c < stat_counters; ++c)
+			line << ", \"" << counter_names[c] << "\": " << counts[c];
+		for(int t = 0; t < stat_timers; ++t)
+			line << ", \"" << timer_names[t] << "_seconds\": " << cycles[t] / cycles_per_second;
+		line << "}\n";
+		*file << line.str() << std::flush;
+	} else {
+		line << model << (last ? " final" : "") << " stats at " << seconds << " s: "
+			<< rate << " events/s (" << recent << " recently)";
+		for(int c = 1; c < stat_counters; ++c) {
+			if(counts[c] > 0)
+				line << ", " << counter_names[c] << " " << counts[c];
+		}
+		for(int t = 0; t < stat_timers; ++t) {
+			if(cycles[t] > 0)
+				line << ", " << timer_names[t] << " " << cycles[t] / cycles_per_second << " s";
+		}
+		std::cerr << line.str() << std::endl;
+	}
+}
@@ -0,0 +1,131 @@
+#ifndef STATS_HPP
+#define STATS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <condition_variable>
+#include <mutex>
+#include "cmdline.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Run statistics for --stats. Each thread counts into a block of its own, so
+// the hot path is a thread-local add with no sharing between threads, and a
+// reporter thread sums the blocks every few seconds. All of it is compiled
+// in only with COARSEN_STATS defined (cmake -DSTATS=ON); otherwise stat_count()
+// and stat_scope are empty and the optimiser removes them.
+#ifdef COARSEN_STATS
+const bool stats_enabled = true;
+#else
+const bool stats_enabled = false;
+#endif
+
+enum stat_counter {
+	stat_events,       // events carried out
+	stat_noop_writes,  // label_lattice cells overwritten with what they held
+	stat_noop_flips,   // mc_2d_voter flips that left the cell as it was
+	stat_vacancy_hops, // B's moved along by mc_2d_AB_stratify vacancies
+	stat_counters
+};
+
+enum stat_timer {
+	stat_recount,      // clone sizes counted from scratch
+	stat_clone_output, // clone sizes written or tallied
+	stat_picture,      // pictures written
+	stat_checkpoint,   // checkpoints written
+	stat_timers
+};
+
+// time stamp counter, or the steady clock where there is none; the reporter
+// works out its rate
+inline uint64_t stat_cycles()
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+// One thread's counts. Only its own thread writes them, so a relaxed load
+// and store is enough and costs no more than a plain add; the atomics only
+// keep the reporter's reads well defined.
+struct alignas(64) thread_stats {
+	std::atomic<uint64_t> counts[stat_counters];
+	std::atomic<uint64_t> cycles[stat_timers];
+
+	thread_stats() {
+		for(int c = 0; c < stat_counters; ++c) counts[c] = 0;
+		for(int t = 0; t < stat_timers; ++t) cycles[t] = 0;
+	}
+
+	static void add(std::atomic<uint64_t> & a, uint64_t n) {
+		a.store(a.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+	}
+};
+
+// the calling thread's block, handed out on first use (and taken back when
+// the thread ends) by attach_stats
+thread_stats & attach_stats();
+inline thread_local thread_stats * current_stats = nullptr;
+
+inline thread_stats & local_stats()
+{
+	return current_stats ? *current_stats : attach_stats();
+}
+
+inline void stat_count(stat_counter c, uint64_t n = 1)
+{
+	if constexpr(stats_enabled)
+		thread_stats::add(local_stats().counts[c], n);
+}
+
+// adds the cycles from construction to destruction to a timer
+class stat_scope {
+public:
+	explicit stat_scope(stat_timer t_): t(t_), start(stats_enabled ? stat_cycles() : 0) {}
+	~stat_scope() {
+		if constexpr(stats_enabled)
+			thread_stats::add(local_stats().cycles[t], stat_cycles() - start);
+	}
+
+private:
+	const stat_timer t;
+	const uint64_t start;
+};
+
+// With --stats, reports the totals of all threads every --stats-every
+// seconds (default 5) and once more when it is destroyed: to standard error
+// as a line of text, or with --stats=file as a line of JSON appended to file.
+// Without the option, or without COARSEN_STATS, it does nothing (but says so
+// if --stats was asked for).
+class stats_reporter {
+public:
+	stats_reporter(const cmdline & args, const char * model);
+	~stats_reporter();
+
+private:
+	void report(bool last);
+
+	const std::string model;
+	std::unique_ptr<std::ofstream> file;
+	double every;
+	std::chrono::steady_clock::time_point start;
+	uint64_t start_cycles;
+	uint64_t last_events;
+	double last_seconds;
+
+	std::thread thread;
+	std::mutex m;
+	std::condition_variable stop_now;
+	bool stopping;
+};
+
+#endif // STATS_HPP
@@ -0,0 +1,126 @@
+#ifndef SUBLATTICE_HPP
+#define SUBLATTICE_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "rng.hpp"
+#include "replicas.hpp"
+#include "stats.hpp"
+
+// Synchronous sublattice kinetic Monte Carlo (Shim and Amar, PRB 71, 125432),
+// for running one lattice on several threads.
+//
+// The rows are cut into one strip per thread and each strip into an upper and
+// a lower half. Time advances in windows of length tau: every thread first
+// runs the events of its upper half for one window, all threads wait, then
+// they do the same for their lower halves. Within a half, events are a
+// Poisson process with that half's own total rate, so each cell still sees
+// its continuous-time dynamics; the approximation is only in the ordering of
+// events across the edge of a half within one window, and vanishes as tau
+// goes to zero.
+//
+// Halves running at the same time are separated by another half. An event
+// reads and writes cells at most Lattice::reach rows from where it starts,
+// so if halves are at least 2*reach rows high no two threads ever touch the
+// same cell, and the shared lattice needs no halo copies or locks.
+//
+// A Lattice provides
+//   N, time
+//   reach            rows an event may touch away from its starting row
+//   row_granularity  halves must begin on a multiple of this row
+//   rate(begin, end) total rate of events starting in rows [begin, end)
+//   stratify_cell(begin, end, rng)
+//                    one event starting uniformly in rows [begin, end)
+//   recount()        bring up to date anything stratify_cell leaves alone,
+//                    once all threads are done
+
+class sublattice_barrier {
+public:
+	explicit sublattice_barrier(int n_): n(n_), waiting(0), generation(0) {}
+
+	void wait() {
+		std::unique_lock<std::mutex> lock(m);
+		uint64_t g = generation;
+		if(++waiting == n) {
+			waiting = 0;
+			generation++;
+			all_here.notify_all();
+		} else
+			all_here.wait(lock, [&] {return generation != g;});
+	}
+
+private:
+	std::mutex m;
+	std::condition_variable all_here;
+	const int n;
+	int waiting;
+	uint64_t generation;
+};
+
+// first row of each half; half h is rows [edge[h], edge[h+1])
+template<typename Lattice>
+std::vector<int> sublattice_edges(int N, int domains)
+{
+	const int unit = Lattice::row_granularity;
+	std::vector<int> edge(2*domains + 1);
+	for(int h = 0; h <= 2*domains; ++h)
+		edge[h] = unit * int(int64_t(h) * (N / unit) / (2*domains));
+	edge[2*domains] = N;
+	return edge;
+}
+
+// whether the grid can be split into that many domains; never for a Lattice
+// whose row_granularity is 0, meaning it has no sublattice runs
+template<typename Lattice>
+bool sublattice_fits(int N, int domains)
+{
+	if(Lattice::row_granularity == 0) return false;
+	std::vector<int> edge = sublattice_edges<Lattice>(N, domains);
+	for(int h = 0; h < 2*domains; ++h)
+		if(edge[h+1] - edge[h] < 2*Lattice::reach) return false;
+	return true;
+}
+
+// Advances grid to the given time on the given number of threads. Each
+// thread has its own generator, seeded from (seed, replica, thread); a run
+// advanced in several legs passes a different leg number to each, so that
+// the legs do not reuse the same random numbers.
+template<typename Lattice>
+void run_sublattice(Lattice & grid, double until, int domains, double tau,
+		uint32_t seed, uint32_t replica, uint32_t leg = 0)
+{
+	const std::vector<int> edge = sublattice_edges<Lattice>(grid.N, domains);
+	sublattice_barrier sync(domains);
+
+	auto worker = [&](int d) {
+		fast_rng r;
+		seed_replica(r, seed, replica, leg*domains + d + 1);
+		for(double t = grid.time; t < until; t += tau) {
+			double window = std::min(tau, until - t);
+			for(int half = 0; half < 2; ++half) {
+				int begin = edge[2*d + half], end = edge[2*d + half + 1];
+				double rate = grid.rate(begin, end);
+				for(double s = r.exponential(rate); s < window; s += r.exponential(rate)) {
+					grid.stratify_cell(begin, end, r);
+					stat_count(stat_events);
+				}
+				sync.wait();
+			}
+		}
+	};
+
+	std::vector<std::thread> pool;
+	for(int d = 1; d < domains; ++d)
+		pool.push_back(std::thread(worker, d));
+	worker(0);
+	for(size_t d = 0; d < pool.size(); ++d)
+		pool[d].join();
+	grid.time = std::max(grid.time, until);
+	grid.recount();
+}
+
+#endif // SUBLATTICE_HPP
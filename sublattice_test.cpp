@@ -0,0 +1,77 @@
+/* Checks that run_sublattice samples the same clone sizes as running the
+ * lattice on one thread: for pure_voter and gut_model_A, the mean number of
+ * clones per replica and the fraction of clones no larger than a few sizes
+ * (points of the clone size CDF) must agree between --domains=1 and
+ * --domains=4 within four standard errors. The window tau is the default
+ * of simulate_lattice.
+*/
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "gut_model_A.hpp"
+#include "lattice_model.hpp"
+#include "layout.hpp"
+#include "pure_voter.hpp"
+#include "replicas.hpp"
+#include "rng.hpp"
+#include "sublattice.hpp"
+#include "test_moments.hpp"
+
+// sizes at which the CDF is compared
+const uint32_t cdf_sizes[] = {2, 8, 32};
+const int cdf_points = sizeof(cdf_sizes) / sizeof(cdf_sizes[0]);
+
+// per replica averages of the clone count, then of the CDF at cdf_sizes
+template<typename Rule>
+std::vector<replica_mean> clone_sizes(int N, double until, int runs, int domains, uint32_t seed)
+{
+	typedef label_lattice<Rule, row_major_layout> lattice;
+	std::vector<replica_mean> m(1 + cdf_points);
+	for(int r = 0; r < runs; ++r) {
+		fast_rng rng;
+		seed_replica(rng, seed, r);
+		lattice grid(N, rng);
+		if(domains > 1)
+			run_sublattice(grid, until, domains, 0.25, seed, r);
+		else {
+			grid.time += grid.next_event(rng);
+			while(grid.time < until) {
+				grid.stratify_cell(rng);
+				grid.time += grid.next_event(rng);
+			}
+		}
+
+		const clone_histogram & h = grid.histogram();
+		double x[1 + cdf_points] = {double(h.clones())};
+		h.for_each([&](uint32_t, uint32_t size) {
+			for(int k = 0; k < cdf_points; ++k)
+				x[1 + k] += size <= cdf_sizes[k] ? 1.0 / h.clones() : 0.0;
+		});
+		for(int k = 0; k <= cdf_points; ++k)
+			m[k].add(x[k]);
+	}
+	return m;
+}
+
+template<typename Rule>
+bool compare(int N, double until, int runs)
+{
+	std::cout << Rule::name() << " N=" << N << " t=" << until << std::endl;
+	const std::vector<replica_mean> a = clone_sizes<Rule>(N, until, runs, 1, 1);
+	const std::vector<replica_mean> b = clone_sizes<Rule>(N, until, runs, 4, 2);
+	bool ok = agree("clones", "1 domain", a[0], "4 domains", b[0]);
+	for(int k = 0; k < cdf_points; ++k)
+		ok &= agree("P(size <= " + std::to_string(cdf_sizes[k]) + ")", "1 domain", a[1 + k],
+			"4 domains", b[1 + k]);
+	return ok;
+}
+
+int main()
+{
+	bool ok = true;
+	ok &= compare<voter_rule>(64, 16, 1000);
+	ok &= compare<gut_rule>(64, 8, 1000);
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,47 @@
+#ifndef TEST_MOMENTS_HPP
+#define TEST_MOMENTS_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+// The tests' comparisons of two ways of sampling the same thing, such as two
+// schedulers or one domain against four.
+
+// the mean of a quantity over independent replicas, and its standard error
+class replica_mean {
+public:
+	replica_mean(): n(0), sum(0), sum2(0) {}
+
+	void add(double x) {
+		n++;
+		sum += x;
+		sum2 += x*x;
+	}
+
+	double mean() const {return sum / n;}
+	double se() const {
+		const double m = mean();
+		return std::sqrt(std::max(0.0, sum2 / n - m*m) / n);
+	}
+
+private:
+	uint64_t n;
+	double sum, sum2;
+};
+
+// Whether a and b agree within four standard errors of their difference;
+// prints the comparison either way.
+inline bool agree(const std::string & what, const std::string & a_name, const replica_mean & a,
+		const std::string & b_name, const replica_mean & b)
+{
+	const double tolerance = 4 * std::sqrt(a.se()*a.se() + b.se()*b.se());
+	const bool ok = std::fabs(a.mean() - b.mean()) <= tolerance;
+	std::cout << "  " << what << ": " << a_name << " " << a.mean() << ", " << b_name << " "
+		<< b.mean() << " (tolerance " << tolerance << ")" << (ok ? "" : "  FAILED") << std::endl;
+	return ok;
+}
+
+#endif // TEST_MOMENTS_HPP
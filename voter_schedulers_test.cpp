@@ -0,0 +1,65 @@
+/* Checks that nfold_lattice samples the same dynamics as grid_lattice on
+ * lattices small enough that clones often take over the whole lattice. Each
+ * case compares one moment, within four standard errors: the fraction of
+ * replicas that fixate where that is near a half, so most sensitive to the
+ * rates, and the mean clone size on a lattice where fixation is rare.
+ * Replicas restart when their clone dies, as in mc_2d_voter.
+*/
+
+#include <cstdint>
+#include <iostream>
+#include "mc_2d_voter.hpp"
+#include "replicas.hpp"
+#include "rng.hpp"
+#include "test_moments.hpp"
+
+struct clone_moments {
+	replica_mean size, fixed;
+};
+
+template<typename Lattice>
+clone_moments survivors(int N, double until, int runs, uint32_t seed)
+{
+	clone_moments m;
+	for(int r = 0; r < runs; ++r) {
+		fast_rng rng;
+		seed_replica(rng, seed, r);
+		Lattice grid(N);
+		while(true) {
+			grid.time += grid.next_event(rng);
+			if(grid.time > until) break;
+			grid.flip(rng);
+			if(grid.empty()) grid.restart();
+		}
+		m.size.add(grid.size());
+		m.fixed.add(grid.size() == uint64_t(N)*N);
+	}
+	return m;
+}
+
+int main()
+{
+	bool ok = true;
+	// on a lattice of side 2 the sites above and below a cell are the same,
+	// as are those to either side
+	const struct {
+		int N;
+		double until;
+		int runs;
+		bool fixation;
+	} cases[] = {
+		{2, 2, 4000, true},
+		{4, 20, 4000, true},
+		{8, 60, 8000, false},
+	};
+	for(const auto & c : cases) {
+		std::cout << "N=" << c.N << " t=" << c.until << std::endl;
+		const clone_moments u = survivors<grid_lattice>(c.N, c.until, c.runs, 1);
+		const clone_moments n = survivors<nfold_lattice>(c.N, c.until, c.runs, 2);
+		if(c.fixation)
+			ok &= agree("fixed fraction", "uniform", u.fixed, "nfold", n.fixed);
+		else
+			ok &= agree("mean size", "uniform", u.size, "nfold", n.size);
+	}
+	return ok ? 0 : 1;
+}